@@ -43,6 +43,56 @@ namespace reshade::api
 		clipboard = 4,
 	};
 
+	/// <summary>
+	/// Data type of the values in a <see cref="effect_uniform_value_update"/>.
+	/// </summary>
+	enum class effect_uniform_value_type
+	{
+		boolean = 0,
+		floating_point = 1,
+		signed_integer = 2,
+		unsigned_integer = 3,
+	};
+
+	/// <summary>
+	/// Describes a single uniform variable update in a call to <see cref="effect_runtime::set_uniform_values"/>.
+	/// </summary>
+	struct effect_uniform_value_update
+	{
+		/// <summary>
+		/// Opaque handle to the uniform variable to update.
+		/// </summary>
+		effect_uniform_variable variable;
+		/// <summary>
+		/// Data type of the values pointed to by <see cref="values"/>, which is converted to the type of the uniform variable as necessary.
+		/// </summary>
+		effect_uniform_value_type type;
+		/// <summary>
+		/// Pointer to an array of values of the specified <see cref="type"/> (<c>bool</c>, <c>float</c>, <c>int32_t</c> or <c>uint32_t</c>).
+		/// </summary>
+		const void *values;
+		/// <summary>
+		/// Number of values to write.
+		/// </summary>
+		uint32_t count;
+		/// <summary>
+		/// Array offset to start writing values to when the uniform variable is an array variable.
+		/// </summary>
+		uint32_t array_index;
+	};
+
+	/// <summary>
+	/// Timing statistics gathered over the last frames, with all durations in nanoseconds.
+	/// </summary>
+	struct effect_statistics
+	{
+		uint64_t average;
+		uint64_t minimum;
+		uint64_t maximum;
+		uint64_t percentile_95;
+		uint64_t percentile_99;
+	};
+
 	/// <summary>
 	/// A post-processing effect runtime, used to control effects.
 	/// <para>ReShade associates an independent post-processing effect runtime with most swap chains.</para>
@@ -842,5 +892,82 @@ namespace reshade::api
 		/// </summary>
 		/// <param name="postfix">Optional string to append to the screenshot filename, or <see langword="nullptr"/> for no postfix.</param>
 		virtual void save_screenshot(const char *postfix = nullptr) = 0;
+
+		/// <summary>
+		/// Gets a boolean indicating whether timing statistics are currently being gathered.
+		/// </summary>
+		virtual bool get_statistics_state() const = 0;
+		/// <summary>
+		/// Enables or disables gathering of timing statistics for techniques, passes and add-on event callbacks, independent of whether the statistics page of the overlay is open.
+		/// </summary>
+		/// <param name="enabled"><see langword="true"/> to enable gathering of timing statistics, or <see langword="false"/> to disable it.</param>
+		virtual void set_statistics_state(bool enabled) = 0;
+
+		/// <summary>
+		/// Gets the CPU and GPU timing statistics of the specified <paramref name="technique"/>.
+		/// </summary>
+		/// <remarks>
+		/// GPU timings lag a few frames behind, since they are read back asynchronously.
+		/// </remarks>
+		/// <param name="technique">Opaque handle to the technique.</param>
+		/// <param name="out_cpu_time">Optional pointer to a variable that is set to the CPU time spent recording the technique.</param>
+		/// <param name="out_gpu_time">Optional pointer to a variable that is set to the GPU time spent executing the technique.</param>
+		/// <returns><see langword="true"/> if statistics are available for the technique, <see langword="false"/> otherwise.</returns>
+		virtual bool get_technique_statistics(effect_technique technique, effect_statistics *out_cpu_time, effect_statistics *out_gpu_time) const = 0;
+		/// <summary>
+		/// Gets the GPU timing statistics of the pass at the specified <paramref name="pass_index"/> in the specified <paramref name="technique"/>.
+		/// </summary>
+		/// <param name="technique">Opaque handle to the technique.</param>
+		/// <param name="pass_index">Index of the pass in the technique.</param>
+		/// <param name="out_gpu_time">Pointer to a variable that is set to the GPU time spent executing the pass.</param>
+		/// <returns><see langword="true"/> if statistics are available for the pass, <see langword="false"/> otherwise.</returns>
+		virtual bool get_technique_pass_statistics(effect_technique technique, size_t pass_index, effect_statistics *out_gpu_time) const = 0;
+		/// <summary>
+		/// Gets the timing statistics of the event callbacks registered by the add-on with the specified name.
+		/// </summary>
+		/// <param name="addon_name">Name of the add-on, as passed during registration.</param>
+		/// <param name="out_cpu_time">Pointer to a variable that is set to the CPU time spent per frame in event callbacks of the add-on.</param>
+		/// <returns><see langword="true"/> if statistics are available for the add-on, <see langword="false"/> otherwise.</returns>
+		virtual bool get_addon_statistics(const char *addon_name, effect_statistics *out_cpu_time) const = 0;
+
+		/// <summary>
+		/// Finds multiple uniform variables in the loaded effects at once and returns handles to them.
+		/// </summary>
+		/// <remarks>
+		/// This will not find uniform variables when performance mode is enabled, since in that case uniform variables are replaced with constants during effect compilation.
+		/// </remarks>
+		/// <param name="effect_name">File name of the effect file the variables are declared in, or <see langword="nullptr"/> to search in all loaded effects.</param>
+		/// <param name="count">Number of variables to find.</param>
+		/// <param name="variable_names">Pointer to an array of names of the uniform variable declarations to find.</param>
+		/// <param name="out_variables">Pointer to an array that is filled with opaque handles to the uniform variables, or zero for those that were not found.</param>
+		virtual void find_uniform_variables(const char *effect_name, size_t count, const char *const *variable_names, effect_uniform_variable *out_variables) const = 0;
+		/// <summary>
+		/// Finds multiple texture variables in the loaded effects at once and returns handles to them.
+		/// </summary>
+		/// <param name="effect_name">File name of the effect file the variables are declared in, or <see langword="nullptr"/> to search in all loaded effects.</param>
+		/// <param name="count">Number of variables to find.</param>
+		/// <param name="variable_names">Pointer to an array of names of the texture variable declarations to find.</param>
+		/// <param name="out_variables">Pointer to an array that is filled with opaque handles to the texture variables, or zero for those that were not found.</param>
+		virtual void find_texture_variables(const char *effect_name, size_t count, const char *const *variable_names, effect_texture_variable *out_variables) const = 0;
+		/// <summary>
+		/// Finds multiple techniques in the loaded effects at once and returns handles to them.
+		/// </summary>
+		/// <param name="effect_name">File name of the effect file the techniques are declared in, or <see langword="nullptr"/> to search in all loaded effects.</param>
+		/// <param name="count">Number of techniques to find.</param>
+		/// <param name="technique_names">Pointer to an array of names of the techniques to find.</param>
+		/// <param name="out_techniques">Pointer to an array that is filled with opaque handles to the techniques, or zero for those that were not found.</param>
+		virtual void find_techniques(const char *effect_name, size_t count, const char *const *technique_names, effect_technique *out_techniques) = 0;
+
+		/// <summary>
+		/// Sets the values of multiple uniform variables at once.
+		/// </summary>
+		/// <remarks>
+		/// This is equivalent to calling the <c>set_uniform_value_*</c> functions for each update, but avoids the per-call overhead when updating many variables every frame.
+		/// Updates with a zero variable handle are ignored.
+		/// Calling this triggers a single <see cref="addon_event::reshade_set_uniform_values" /> event in other add-ons.
+		/// </remarks>
+		/// <param name="count">Number of updates.</param>
+		/// <param name="updates">Pointer to an array of updates to apply.</param>
+		virtual void set_uniform_values(size_t count, const effect_uniform_value_update *updates) = 0;
 	};
 }
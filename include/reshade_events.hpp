@@ -1809,8 +1809,18 @@ namespace reshade
 		/// </remarks>
 		reshade_overlay_technique,
 
+		/// <summary>
+		/// Called before multiple uniform variables are changed at once via <see cref="api::effect_runtime::set_uniform_values"/>, with the new values.
+		/// <para>Callback function signature: <c>bool (api::effect_runtime *runtime, size_t count, const api::effect_uniform_value_update *updates)</c></para>
+		/// </summary>
+		/// <remarks>
+		/// To prevent the variable values from being changed, return <see langword="true"/>, otherwise return <see langword="false"/>.
+		/// The <see cref="reshade_set_uniform_value"/> event is not triggered for the individual variables of a batched update.
+		/// </remarks>
+		reshade_set_uniform_values = 103,
+
 #if RESHADE_ADDON
-		max = 103 // Last value used internally by ReShade to determine number of events in this enum
+		max = 104 // Last value used internally by ReShade to determine number of events in this enum
 #endif
 	};
 
@@ -1958,4 +1968,6 @@ namespace reshade
 
 	RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_overlay_uniform_variable, bool, api::effect_runtime *runtime, api::effect_uniform_variable variable);
 	RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_overlay_technique, bool, api::effect_runtime *runtime, api::effect_technique technique);
+
+	RESHADE_DEFINE_ADDON_EVENT_TRAITS(addon_event::reshade_set_uniform_values, bool, api::effect_runtime *runtime, size_t count, const api::effect_uniform_value_update *updates);
 }
@@ -6,6 +6,8 @@
 #pragma once
 
 #include "reshade_api.hpp"
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -42,6 +44,12 @@ namespace reshade
 		bool external = true;
 
 		std::vector<std::pair<uint32_t, void *>> event_callbacks;
+		/// <summary>
+		/// Total time spent in event callbacks of this add-on while statistics were gathered, in nanoseconds.
+		/// This is kept in a separate allocation, so that event callback lists can reference it even if the list of add-ons is reallocated or the add-on is unloaded.
+		/// It is never reset, since multiple effect runtimes read it, each of which keeps track of the value it last saw instead.
+		/// </summary>
+		std::shared_ptr<std::atomic<uint64_t>> callback_duration = std::make_shared<std::atomic<uint64_t>>(0);
 #if RESHADE_GUI
 		void(*settings_overlay_callback)(api::effect_runtime *) = nullptr;
 		std::vector<overlay_callback> overlay_callbacks;
@@ -9,6 +9,7 @@
 #include "addon_manager.hpp"
 #include "dll_log.hpp"
 #include "ini_file.hpp"
+#include <mutex>
 #include <algorithm> // std::find, std::find_if, std::remove, std::remove_if
 #include <Windows.h>
 
@@ -127,6 +128,7 @@ static const char *addon_event_to_string(reshade::addon_event ev)
 	case addon_event::reshade_open_overlay: return "reshade_open_overlay";
 	case addon_event::reshade_overlay_uniform_variable: return "reshade_overlay_uniform_variable";
 	case addon_event::reshade_overlay_technique: return "reshade_overlay_technique";
+	case addon_event::reshade_set_uniform_values: return "reshade_set_uniform_values";
 	}
 	return "unknown";
 }
@@ -136,10 +138,31 @@ static const char *addon_event_to_string(reshade::addon_event ev)
 bool reshade::addon_enabled = true;
 #endif
 bool reshade::addon_all_loaded = true;
-std::vector<void *> reshade::addon_event_list[static_cast<uint32_t>(reshade::addon_event::max)];
+std::atomic<const std::vector<reshade::addon_event_callback> *> reshade::addon_event_list[static_cast<uint32_t>(reshade::addon_event::max)] = {};
+std::atomic<uint64_t> reshade::addon_event_mask[(static_cast<uint32_t>(reshade::addon_event::max) + 63) / 64] = {};
+std::atomic<uint32_t> reshade::addon_statistics_enabled = 0;
 std::vector<reshade::addon_info> reshade::addon_loaded_info;
-thread_local const reshade::addon_info *reshade::addon_current = nullptr;
+thread_local const void *reshade::addon_current = nullptr;
 static unsigned long s_reference_count = 0;
+static std::mutex s_event_list_mutex;
+static std::vector<const std::vector<reshade::addon_event_callback> *> s_retired_event_lists;
+
+static void publish_addon_event_list(uint32_t ev, std::vector<reshade::addon_event_callback> &&event_list)
+{
+	const uint64_t event_bit = 1ull << (ev % 64);
+
+	const std::vector<reshade::addon_event_callback> *const new_event_list = event_list.empty() ? nullptr : new std::vector<reshade::addon_event_callback>(std::move(event_list));
+	const std::vector<reshade::addon_event_callback> *const old_event_list = reshade::addon_event_list[ev].exchange(new_event_list, std::memory_order_acq_rel);
+
+	if (new_event_list != nullptr)
+		reshade::addon_event_mask[ev / 64].fetch_or(event_bit, std::memory_order_release);
+	else
+		reshade::addon_event_mask[ev / 64].fetch_and(~event_bit, std::memory_order_release);
+
+	// Other threads may still be iterating over the previous list, so keep it alive until all add-ons were unloaded
+	if (old_event_list != nullptr)
+		s_retired_event_lists.push_back(old_event_list);
+}
 
 void reshade::load_addons()
 {
@@ -379,6 +402,15 @@ void reshade::unload_addons()
 	unregister_addon_effect_runtime_sync();
 #endif
 
+	// No more events are invoked at this point, so can safely free the callback lists that were replaced while add-ons were loaded
+	{
+		const std::unique_lock<std::mutex> lock(s_event_list_mutex);
+
+		for (const std::vector<addon_event_callback> *const event_list : s_retired_event_lists)
+			delete event_list;
+		s_retired_event_lists.clear();
+	}
+
 	// Remove all unloaded add-ons
 	addon_loaded_info.erase(
 		std::remove_if(addon_loaded_info.begin(), addon_loaded_info.end(),
@@ -576,8 +608,16 @@ void ReShadeRegisterEventForAddon(void *module, reshade::addon_event ev, void *c
 	}
 #endif
 
-	std::vector<void *> &event_list = reshade::addon_event_list[static_cast<uint32_t>(ev)];
-	event_list.push_back(callback);
+	{
+		const std::unique_lock<std::mutex> lock(s_event_list_mutex);
+
+		std::vector<reshade::addon_event_callback> event_list;
+		if (const std::vector<reshade::addon_event_callback> *const old_event_list = reshade::addon_event_list[static_cast<uint32_t>(ev)].load(std::memory_order_acquire))
+			event_list = *old_event_list;
+		event_list.push_back({ callback, info->handle, info->callback_duration });
+
+		publish_addon_event_list(static_cast<uint32_t>(ev), std::move(event_list));
+	}
 
 	info->event_callbacks.emplace_back(static_cast<uint32_t>(ev), callback);
 
@@ -605,8 +645,19 @@ void ReShadeUnregisterEventForAddon(void *module, reshade::addon_event ev, void
 		return;
 #endif
 
-	std::vector<void *> &event_list = reshade::addon_event_list[static_cast<uint32_t>(ev)];
-	event_list.erase(std::remove(event_list.begin(), event_list.end(), callback), event_list.end());
+	{
+		const std::unique_lock<std::mutex> lock(s_event_list_mutex);
+
+		std::vector<reshade::addon_event_callback> event_list;
+		if (const std::vector<reshade::addon_event_callback> *const old_event_list = reshade::addon_event_list[static_cast<uint32_t>(ev)].load(std::memory_order_acquire))
+			event_list = *old_event_list;
+		event_list.erase(std::remove_if(event_list.begin(), event_list.end(),
+			[callback](const reshade::addon_event_callback &item) {
+				return item.callback == callback;
+			}), event_list.end());
+
+		publish_addon_event_list(static_cast<uint32_t>(ev), std::move(event_list));
+	}
 
 	info->event_callbacks.erase(std::remove(info->event_callbacks.begin(), info->event_callbacks.end(), std::make_pair(static_cast<uint32_t>(ev), callback)), info->event_callbacks.end());
 
@@ -7,6 +7,8 @@
 
 #include "addon.hpp"
 #include "reshade_events.hpp"
+#include <atomic>
+#include <chrono>
 
 #if RESHADE_ADDON
 
@@ -20,10 +22,35 @@ namespace reshade
 #endif
 	extern bool addon_all_loaded;
 
+	struct addon_event_callback
+	{
+		void *callback;
+		/// <summary>
+		/// Module handle of the add-on that registered this callback, cached so that the recursion check does not have to look it up on every invocation.
+		/// </summary>
+		const void *module;
+		/// <summary>
+		/// Time measurement of the add-on that registered this callback (see <see cref="addon_info::callback_duration"/>).
+		/// Shares ownership, since a dispatch may still iterate over a retired list referencing it after the add-on was unloaded.
+		/// </summary>
+		std::shared_ptr<std::atomic<uint64_t>> duration;
+	};
+
 	/// <summary>
 	/// List of add-on event callbacks.
+	/// These lists are immutable once published, registering or unregistering a callback swaps in a new copy instead.
+	/// </summary>
+	extern std::atomic<const std::vector<addon_event_callback> *> addon_event_list[];
+
+	/// <summary>
+	/// Bit mask of events that have at least one callback registered, so that unused events cost a single bit test.
+	/// </summary>
+	extern std::atomic<uint64_t> addon_event_mask[];
+
+	/// <summary>
+	/// Number of effect runtimes that currently gather statistics, measuring the time spent in add-on event callbacks while this is not zero.
 	/// </summary>
-	extern std::vector<void *> addon_event_list[];
+	extern std::atomic<uint32_t> addon_statistics_enabled;
 
 	/// <summary>
 	/// List of currently loaded add-ons.
@@ -31,9 +58,9 @@ namespace reshade
 	extern std::vector<addon_info> addon_loaded_info;
 
 	/// <summary>
-	/// Pointer to the add-on that is currently executing.
+	/// Module handle of the add-on that is currently executing.
 	/// </summary>
-	extern thread_local const addon_info *addon_current;
+	extern thread_local const void *addon_current;
 
 	/// <summary>
 	/// Loads any add-ons found in the configured search paths.
@@ -61,7 +88,7 @@ namespace reshade
 	template <addon_event ev>
 	bool has_addon_event()
 	{
-		return !addon_event_list[static_cast<uint32_t>(ev)].empty();
+		return (addon_event_mask[static_cast<uint32_t>(ev) / 64].load(std::memory_order_relaxed) & (1ull << (static_cast<uint32_t>(ev) % 64))) != 0;
 	}
 
 	/// <summary>
@@ -115,9 +142,17 @@ namespace reshade
 		if (!addon_enabled)
 			return;
 #endif
-		const std::vector<void *> &event_list = addon_event_list[static_cast<uint32_t>(ev)];
-		for (size_t cb = 0, count = event_list.size(); cb < count; ++cb) // Generates better code than ranged-based for loop
+		if (!has_addon_event<ev>())
+			return;
+
+		const std::vector<addon_event_callback> *const event_list = addon_event_list[static_cast<uint32_t>(ev)].load(std::memory_order_acquire);
+		if (event_list == nullptr)
+			return;
+
+		for (size_t cb = 0, count = event_list->size(); cb < count; ++cb) // Generates better code than ranged-based for loop
 		{
+			const addon_event_callback &event_callback = (*event_list)[cb];
+
 			bool first_invocation = false;
 			if constexpr (
 				ev == addon_event::reshade_present ||
@@ -131,16 +166,27 @@ namespace reshade
 				// Prevent recursive invocation of events
 				if (nullptr == addon_current)
 				{
-					addon_current = find_addon(event_list[cb]);
+					addon_current = event_callback.module;
 					first_invocation = true;
 				}
-				else if (find_addon(event_list[cb]) == addon_current)
+				else if (event_callback.module == addon_current)
 				{
 					continue;
 				}
 			}
 
-			reinterpret_cast<typename addon_event_traits<ev>::decl>(event_list[cb])(std::forward<Args>(args)...);
+			if (addon_statistics_enabled.load(std::memory_order_relaxed) != 0)
+			{
+				const std::chrono::high_resolution_clock::time_point time_callback_started = std::chrono::high_resolution_clock::now();
+
+				reinterpret_cast<typename addon_event_traits<ev>::decl>(event_callback.callback)(std::forward<Args>(args)...);
+
+				event_callback.duration->fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - time_callback_started).count(), std::memory_order_relaxed);
+			}
+			else
+			{
+				reinterpret_cast<typename addon_event_traits<ev>::decl>(event_callback.callback)(std::forward<Args>(args)...);
+			}
 
 			if (first_invocation)
 				addon_current = nullptr;
@@ -178,10 +224,18 @@ namespace reshade
 		if (!addon_enabled)
 			return false;
 #endif
+		if (!has_addon_event<ev>())
+			return false;
+
+		const std::vector<addon_event_callback> *const event_list = addon_event_list[static_cast<uint32_t>(ev)].load(std::memory_order_acquire);
+		if (event_list == nullptr)
+			return false;
+
 		bool skip = false;
-		const std::vector<void *> &event_list = addon_event_list[static_cast<uint32_t>(ev)];
-		for (size_t cb = 0, count = event_list.size(); cb < count; ++cb)
+		for (size_t cb = 0, count = event_list->size(); cb < count; ++cb)
 		{
+			const addon_event_callback &event_callback = (*event_list)[cb];
+
 			bool first_invocation = false;
 			if constexpr (
 				ev == addon_event::reshade_set_uniform_value ||
@@ -190,22 +244,35 @@ namespace reshade
 				ev == addon_event::reshade_reorder_techniques ||
 				ev == addon_event::reshade_open_overlay ||
 				ev == addon_event::reshade_overlay_uniform_variable ||
-				ev == addon_event::reshade_overlay_technique)
+				ev == addon_event::reshade_overlay_technique ||
+				ev == addon_event::reshade_set_uniform_values)
 			{
 				// Prevent recursive invocation of events
 				if (nullptr == addon_current)
 				{
-					addon_current = find_addon(event_list[cb]);
+					addon_current = event_callback.module;
 					first_invocation = true;
 				}
-				else if (find_addon(event_list[cb]) == addon_current)
+				else if (event_callback.module == addon_current)
 				{
 					continue;
 				}
 			}
 
-			if (reinterpret_cast<typename addon_event_traits<ev>::decl>(event_list[cb])(std::forward<Args>(args)...))
-				skip = true;
+			if (addon_statistics_enabled.load(std::memory_order_relaxed) != 0)
+			{
+				const std::chrono::high_resolution_clock::time_point time_callback_started = std::chrono::high_resolution_clock::now();
+
+				if (reinterpret_cast<typename addon_event_traits<ev>::decl>(event_callback.callback)(std::forward<Args>(args)...))
+					skip = true;
+
+				event_callback.duration->fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - time_callback_started).count(), std::memory_order_relaxed);
+			}
+			else
+			{
+				if (reinterpret_cast<typename addon_event_traits<ev>::decl>(event_callback.callback)(std::forward<Args>(args)...))
+					skip = true;
+			}
 
 			if (first_invocation)
 				addon_current = nullptr;
@@ -9,6 +9,75 @@
 #include <cstring> // std::memcpy, std::memset
 #include <algorithm> // std::max, std::min
 
+static thread_local reshadefx::parser_arena *s_current_arena = nullptr;
+
+reshadefx::parser_arena::~parser_arena()
+{
+	for (char *const block : _blocks)
+		::operator delete(block);
+}
+
+reshadefx::parser_arena::scope::scope(parser_arena &arena) :
+	_previous(s_current_arena)
+{
+	s_current_arena = &arena;
+}
+reshadefx::parser_arena::scope::~scope()
+{
+	s_current_arena = _previous;
+}
+
+reshadefx::parser_arena *reshadefx::parser_arena::current()
+{
+	return s_current_arena;
+}
+
+size_t reshadefx::parser_arena::size_class(size_t size)
+{
+	size_t index = 0;
+	for (size_t class_size = min_allocation_size; class_size < size; class_size *= 2)
+		index++;
+	return index;
+}
+
+void *reshadefx::parser_arena::allocate(size_t size)
+{
+	const size_t index = size_class(size);
+	if (index >= num_size_classes)
+		return ::operator new(size);
+
+	// Reuse memory that was freed before if possible
+	if (void *const ptr = _free_lists[index])
+	{
+		_free_lists[index] = *static_cast<void **>(ptr);
+		return ptr;
+	}
+
+	const size_t allocation_size = min_allocation_size << index;
+	if (_block_offset + allocation_size > block_size)
+	{
+		_blocks.push_back(static_cast<char *>(::operator new(block_size)));
+		_block_offset = 0;
+	}
+
+	void *const ptr = _blocks.back() + _block_offset;
+	_block_offset += allocation_size;
+	return ptr;
+}
+void reshadefx::parser_arena::deallocate(void *ptr, size_t size)
+{
+	const size_t index = size_class(size);
+	if (index >= num_size_classes)
+	{
+		// Large allocations were made from the global heap (see 'allocate' above)
+		::operator delete(ptr);
+		return;
+	}
+
+	*static_cast<void **>(ptr) = _free_lists[index];
+	_free_lists[index] = ptr;
+}
+
 reshadefx::type reshadefx::type::merge(const type &lhs, const type &rhs)
 {
 	type result;
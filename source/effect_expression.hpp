@@ -151,6 +151,103 @@ namespace reshadefx
 		std::vector<constant> array_data;
 	};
 
+	/// <summary>
+	/// Memory arena for the short-lived allocations made while parsing (like the access chains of temporary expressions).
+	/// Memory is taken from large blocks owned by the arena and freed allocations are kept in per-size free lists for reuse, so that parsing does not contend on the global heap with other threads.
+	/// </summary>
+	class parser_arena
+	{
+	public:
+		parser_arena() = default;
+		~parser_arena();
+
+		parser_arena(const parser_arena &) = delete;
+		parser_arena &operator=(const parser_arena &) = delete;
+
+		/// <summary>
+		/// Makes an arena the one picked up by allocators constructed on the current thread for as long as this object exists.
+		/// </summary>
+		class scope
+		{
+		public:
+			explicit scope(parser_arena &arena);
+			~scope();
+
+			scope(const scope &) = delete;
+			scope &operator=(const scope &) = delete;
+
+		private:
+			parser_arena *_previous;
+		};
+
+		/// <summary>
+		/// Gets the arena that is currently used on this thread, or <see langword="nullptr"/> if there is none.
+		/// </summary>
+		static parser_arena *current();
+
+		/// <summary>
+		/// Allocates the specified amount of memory from the arena (or the global heap if it is too large).
+		/// </summary>
+		void *allocate(size_t size);
+		/// <summary>
+		/// Returns memory previously allocated from this arena with the same size to it for reuse.
+		/// </summary>
+		void deallocate(void *ptr, size_t size);
+
+	private:
+		static constexpr size_t block_size = 64 * 1024;
+		static constexpr size_t min_allocation_size = 16;
+		static constexpr size_t num_size_classes = 9; // 16 bytes up to 4 KiB
+
+		static size_t size_class(size_t size);
+
+		std::vector<char *> _blocks;
+		size_t _block_offset = block_size;
+		void *_free_lists[num_size_classes] = {};
+	};
+
+	/// <summary>
+	/// Allocator that uses the arena that was current on this thread when it was constructed, or the global heap if there was none.
+	/// The arena is kept with the allocator and moves along with containers, so memory is always returned to where it came from, regardless of which arena is current when it is freed.
+	/// </summary>
+	template <typename T>
+	struct parser_allocator
+	{
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		parser_allocator() : _arena(parser_arena::current()) {}
+		template <typename U>
+		parser_allocator(const parser_allocator<U> &other) : _arena(other._arena) {}
+
+		T *allocate(size_t n)
+		{
+			if (_arena != nullptr)
+				return static_cast<T *>(_arena->allocate(n * sizeof(T)));
+			return static_cast<T *>(::operator new(n * sizeof(T)));
+		}
+		void deallocate(T *ptr, size_t n)
+		{
+			if (_arena != nullptr)
+				_arena->deallocate(ptr, n * sizeof(T));
+			else
+				::operator delete(ptr);
+		}
+
+		template <typename U>
+		bool operator==(const parser_allocator<U> &rhs) const { return _arena == rhs._arena; }
+		template <typename U>
+		bool operator!=(const parser_allocator<U> &rhs) const { return _arena != rhs._arena; }
+
+	private:
+		template <typename U>
+		friend struct parser_allocator;
+
+		parser_arena *_arena;
+	};
+
 	/// <summary>
 	/// Structures which keeps track of the access chain of an expression
 	/// </summary>
@@ -180,7 +277,8 @@ namespace reshadefx
 		bool is_lvalue = false;
 		bool is_constant = false;
 		reshadefx::location location;
-		std::vector<operation> chain;
+		// Access chains only live as long as the expressions built during parsing, so take them from the arena of the parser (if one is current when the expression is constructed)
+		std::vector<operation, parser_allocator<operation>> chain;
 
 		/// <summary>
 		/// Initializes the expression to a l-value.
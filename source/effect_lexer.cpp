@@ -5,6 +5,7 @@
 
 #include "effect_lexer.hpp"
 #include <cassert>
+#include <cstring> // std::memchr
 #include <string_view>
 #include <unordered_map> // Used for static lookup tables
 
@@ -585,6 +586,8 @@ next_token:
 	switch (s_type_lookup[uint8_t(*_cur)])
 	{
 	case 0xFF: // EOF
+		if (_cur == _end && read_input_stream())
+			goto next_token;
 		tok.id = tokenid::end_of_file;
 		return tok;
 	case SPACE:
@@ -886,10 +889,110 @@ void reshadefx::lexer::skip_to_next_line()
 	}
 }
 
+void reshadefx::lexer::skip_to_next_conditional_directive()
+{
+	bool in_comment = false;
+
+	while (_cur < _end)
+	{
+		const auto line_end_ptr = static_cast<const std::string::value_type *>(std::memchr(_cur, '\n', _end - _cur));
+		const auto line_end = line_end_ptr != nullptr ? line_end_ptr : _end;
+
+		if (!in_comment)
+		{
+			auto it = _cur;
+			while (it < line_end && s_type_lookup[uint8_t(*it)] == SPACE)
+				++it;
+
+			if (it < line_end && *it == '#')
+			{
+				++it;
+				while (it < line_end && s_type_lookup[uint8_t(*it)] == SPACE)
+					++it;
+
+				auto name_end = it;
+				while (name_end < line_end && (s_type_lookup[uint8_t(*name_end)] == IDENT || s_type_lookup[uint8_t(*name_end)] == DIGIT))
+					++name_end;
+
+				const std::string_view name(it, name_end - it);
+				if (name == "if" || name == "ifdef" || name == "ifndef" || name == "elif" || name == "else" || name == "endif" || (name == "line" && !_ignore_line_directives))
+					return; // Stop at the beginning of this line, so that the directive is lexed as usual
+			}
+		}
+
+		// Only need to look at the individual characters of a line if it may start or end a block comment
+		if (in_comment || std::memchr(_cur, '/', line_end - _cur) != nullptr)
+		{
+			for (auto it = _cur; it < line_end; ++it)
+			{
+				if (in_comment)
+				{
+					if (it[0] == '*' && it[1] == '/')
+						in_comment = false, ++it;
+				}
+				else if (it[0] == '"')
+				{
+					// Skip string literals, so that comment characters inside them are ignored
+					for (++it; it < line_end && *it != '"'; ++it)
+						if (*it == '\\')
+							++it;
+				}
+				else if (it[0] == '/' && it[1] == '/')
+				{
+					break;
+				}
+				else if (it[0] == '/' && it[1] == '*')
+				{
+					in_comment = true, ++it;
+				}
+			}
+		}
+
+		if (line_end == _end)
+		{
+			skip(_end - _cur);
+			break;
+		}
+
+		_cur = line_end + 1;
+		_cur_location.line++;
+		_cur_location.column = 1;
+	}
+}
+
+bool reshadefx::lexer::read_input_stream()
+{
+	if (_input_stream == nullptr)
+		return false;
+
+	// Appending may reallocate the input string, so restore the pointers from offsets afterwards
+	const size_t offset = input_offset();
+
+	// Drop input that cannot be returned to anymore before appending more, so that only a small window of the streamed source code is kept around
+	if (const size_t discard_offset = std::min(_discard_offset, offset);
+		discard_offset > _input_base)
+	{
+		_input.erase(0, discard_offset - _input_base);
+		_input_base = discard_offset;
+	}
+
+	if (!_input_stream->read(_input))
+	{
+		_input_stream = nullptr;
+		_cur = _input.data() + (offset - _input_base);
+		_end = _input.data() + _input.size();
+		return false;
+	}
+
+	_cur = _input.data() + (offset - _input_base);
+	_end = _input.data() + _input.size();
+	return true;
+}
+
 void reshadefx::lexer::reset_to_offset(size_t offset)
 {
-	assert(offset < _input.size());
-	_cur = _input.data() + offset;
+	assert(offset >= _input_base && offset - _input_base < _input.size());
+	_cur = _input.data() + (offset - _input_base);
 }
 
 void reshadefx::lexer::parse_identifier(token &tok) const
@@ -1223,3 +1326,40 @@ void reshadefx::lexer::parse_numeric_literal(token &tok) const
 
 	tok.length = end - begin;
 }
+
+void reshadefx::source_stream::write(std::string_view source)
+{
+	if (source.empty())
+		return;
+
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+		assert(!_closed);
+		_pending += source;
+	}
+
+	_condition.notify_one();
+}
+void reshadefx::source_stream::close()
+{
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+		_closed = true;
+	}
+
+	_condition.notify_one();
+}
+
+bool reshadefx::source_stream::read(std::string &source)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_condition.wait(lock, [this]() { return !_pending.empty() || _closed; });
+
+	if (_pending.empty())
+		return false;
+
+	source += _pending;
+	// Clear instead of swapping, so that the memory can be reused for the next write
+	_pending.clear();
+	return true;
+}
@@ -6,9 +6,43 @@
 #pragma once
 
 #include "effect_token.hpp"
+#include <mutex>
+#include <string_view>
+#include <condition_variable>
 
 namespace reshadefx
 {
+	/// <summary>
+	/// A stream of source code that one thread writes to (e.g. the preprocessor), while a lexical analyzer on another thread reads from it.
+	/// </summary>
+	class source_stream
+	{
+	public:
+		/// <summary>
+		/// Appends source code to the stream.
+		/// This must always end on a line boundary, so that no token is split between two writes.
+		/// </summary>
+		/// <param name="source">Source code to append.</param>
+		void write(std::string_view source);
+		/// <summary>
+		/// Marks the end of the stream, after which no more source code may be written.
+		/// </summary>
+		void close();
+
+		/// <summary>
+		/// Waits for more source code to become available and appends it to the specified string.
+		/// </summary>
+		/// <param name="source">String to append the source code to.</param>
+		/// <returns><see langword="true"/> if source code was appended, <see langword="false"/> if the stream was closed and there is nothing left to read.</returns>
+		bool read(std::string &source);
+
+	private:
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		std::string _pending;
+		bool _closed = false;
+	};
+
 	/// <summary>
 	/// A lexical analyzer for C-like languages.
 	/// </summary>
@@ -41,8 +75,9 @@ namespace reshadefx
 		lexer &operator=(const lexer &lexer)
 		{
 			_input = lexer._input;
+			_input_base = lexer._input_base;
 			_cur_location = lexer._cur_location;
-			reset_to_offset(lexer._cur - lexer._input.data());
+			reset_to_offset(lexer.input_offset());
 			_end = _input.data() + _input.size();
 			_ignore_comments = lexer._ignore_comments;
 			_ignore_whitespace = lexer._ignore_whitespace;
@@ -50,21 +85,35 @@ namespace reshadefx
 			_ignore_keywords = lexer._ignore_keywords;
 			_escape_string_literals = lexer._escape_string_literals;
 			_ignore_line_directives = lexer._ignore_line_directives;
+			_input_stream = lexer._input_stream;
+			_discard_offset = lexer._discard_offset;
 
 			return *this;
 		}
 
 		/// <summary>
-		/// Gets the current position in the input string.
+		/// Gets the current position in the input, counted from the start of everything that was read (including input that was already discarded, see <see cref="discard_input_before"/>).
 		/// </summary>
-		size_t input_offset() const { return _cur - _input.data(); }
+		size_t input_offset() const { return _input_base + (_cur - _input.data()); }
 
 		/// <summary>
 		/// Gets the input string this lexical analyzer works on.
+		/// This only holds what was not discarded yet when reading from an input stream.
 		/// </summary>
 		/// <returns>Constant reference to the input string.</returns>
 		const std::string &input_string() const { return _input; }
 
+		/// <summary>
+		/// Sets a stream to read more input from whenever the end of the current input string is reached, instead of reporting the end of the file right away.
+		/// </summary>
+		/// <param name="stream">Stream to read from, or <see langword="nullptr"/> to only lex the input string.</param>
+		void set_input_stream(source_stream *stream) { _input_stream = stream; }
+		/// <summary>
+		/// Allows input before the specified <paramref name="offset"/> to be discarded the next time more input is read from the input stream, so that the input string does not grow to hold everything that was streamed.
+		/// </summary>
+		/// <param name="offset">Offset in characters (see <see cref="input_offset"/>) of the earliest position that may still be passed to <see cref="reset_to_offset"/>.</param>
+		void discard_input_before(size_t offset) { _discard_offset = offset; }
+
 		/// <summary>
 		/// Performs lexical analysis on the input string and return the next token in sequence.
 		/// </summary>
@@ -79,11 +128,16 @@ namespace reshadefx
 		/// Advances to the next new line, ignoring all tokens.
 		/// </summary>
 		void skip_to_next_line();
+		/// <summary>
+		/// Advances to the beginning of the next line containing a conditional preprocessor directive (or a #line directive), ignoring everything in between.
+		/// This only tracks comments, so is a lot faster than lexing the skipped text token by token.
+		/// </summary>
+		void skip_to_next_conditional_directive();
 
 		/// <summary>
 		/// Resets position to the specified <paramref name="offset"/>.
 		/// </summary>
-		/// <param name="offset">Offset in characters from the start of the input string.</param>
+		/// <param name="offset">Offset in characters (see <see cref="input_offset"/>).</param>
 		void reset_to_offset(size_t offset);
 
 	private:
@@ -92,6 +146,11 @@ namespace reshadefx
 		/// </summary>
 		/// <param name="length">Number of input characters to skip.</param>
 		void skip(size_t length);
+		/// <summary>
+		/// Waits for more input from the input stream and appends it to the input string.
+		/// </summary>
+		/// <returns><see langword="true"/> if input was appended, <see langword="false"/> if the end of the input stream was reached.</returns>
+		bool read_input_stream();
 
 		void parse_identifier(token &tok) const;
 		bool parse_pp_directive(token &tok);
@@ -99,8 +158,11 @@ namespace reshadefx
 		void parse_numeric_literal(token &tok) const;
 
 		std::string _input;
+		size_t _input_base = 0;
 		location _cur_location;
 		const std::string::value_type *_cur, *_end;
+		source_stream *_input_stream = nullptr;
+		size_t _discard_offset = 0;
 
 		bool _ignore_comments;
 		bool _ignore_whitespace;
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "effect_module.hpp"
+#include <cstring> // std::memcpy
+
+using namespace reshadefx;
+
+// Increase this whenever the layout of any of the structures in the effect module (or the data the runtime appends to it) changes, so that stale cache files are discarded
+static constexpr uint32_t s_module_magic = 0x4D584652; // 'RFXM'
+static constexpr uint32_t s_module_version = 2;
+
+namespace
+{
+	struct module_writer
+	{
+		explicit module_writer(std::string &data) : data(data) {}
+
+		void write(uint32_t value)
+		{
+			data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+		void write(uint64_t value)
+		{
+			data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+		void write(float value)
+		{
+			data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+		void write(bool value)
+		{
+			data.push_back(value ? '\1' : '\0');
+		}
+		void write(const std::string &value)
+		{
+			write(static_cast<uint32_t>(value.size()));
+			data.append(value);
+		}
+		void write(const type &value)
+		{
+			write(static_cast<uint32_t>(value.base));
+			write(static_cast<uint32_t>(value.rows));
+			write(static_cast<uint32_t>(value.cols));
+			write(static_cast<uint32_t>(value.qualifiers));
+			write(value.array_length);
+			write(value.struct_definition);
+		}
+		void write(const constant &value)
+		{
+			data.append(reinterpret_cast<const char *>(value.as_uint), sizeof(value.as_uint));
+			write(value.string_data);
+			write(value.array_data);
+		}
+		void write(const annotation &value)
+		{
+			write(value.type);
+			write(value.name);
+			write(value.value);
+		}
+		void write(const texture &value)
+		{
+			write(value.width);
+			write(value.height);
+			write(static_cast<uint32_t>(value.depth));
+			write(static_cast<uint32_t>(value.levels));
+			write(static_cast<uint32_t>(value.type));
+			write(static_cast<uint32_t>(value.format));
+			write(value.id);
+			write(value.name);
+			write(value.unique_name);
+			write(value.semantic);
+			write(value.annotations);
+			write(value.render_target);
+			write(value.storage_access);
+			write(value.semantic_binding);
+		}
+		void write(const sampler &value)
+		{
+			write(static_cast<uint32_t>(value.filter));
+			write(static_cast<uint32_t>(value.address_u));
+			write(static_cast<uint32_t>(value.address_v));
+			write(static_cast<uint32_t>(value.address_w));
+			write(value.min_lod);
+			write(value.max_lod);
+			write(value.lod_bias);
+			write(value.type);
+			write(value.id);
+			write(value.name);
+			write(value.unique_name);
+			write(value.texture_name);
+			write(value.annotations);
+			write(value.srgb);
+		}
+		void write(const storage &value)
+		{
+			write(static_cast<uint32_t>(value.level));
+			write(value.type);
+			write(value.id);
+			write(value.name);
+			write(value.unique_name);
+			write(value.texture_name);
+		}
+		void write(const uniform &value)
+		{
+			write(value.type);
+			write(value.name);
+			write(value.unique_name);
+			write(value.size);
+			write(value.offset);
+			write(value.annotations);
+			write(value.has_initializer_value);
+			write(value.initializer_value);
+		}
+		void write(const texture_binding &value)
+		{
+			write(static_cast<uint64_t>(value.index));
+			write(value.entry_point_binding);
+			write(value.srgb);
+		}
+		void write(const sampler_binding &value)
+		{
+			write(static_cast<uint64_t>(value.index));
+			write(value.entry_point_binding);
+		}
+		void write(const storage_binding &value)
+		{
+			write(static_cast<uint64_t>(value.index));
+			write(value.entry_point_binding);
+		}
+		void write(const pass &value)
+		{
+			write(value.name);
+			for (const std::string &render_target_name : value.render_target_names)
+				write(render_target_name);
+			write(value.vs_entry_point);
+			write(value.ps_entry_point);
+			write(value.cs_entry_point);
+			write(value.generate_mipmaps);
+			write(value.clear_render_targets);
+			for (int i = 0; i < 8; ++i)
+			{
+				write(value.blend_enable[i]);
+				write(static_cast<uint32_t>(value.source_color_blend_factor[i]));
+				write(static_cast<uint32_t>(value.dest_color_blend_factor[i]));
+				write(static_cast<uint32_t>(value.color_blend_op[i]));
+				write(static_cast<uint32_t>(value.source_alpha_blend_factor[i]));
+				write(static_cast<uint32_t>(value.dest_alpha_blend_factor[i]));
+				write(static_cast<uint32_t>(value.alpha_blend_op[i]));
+				write(static_cast<uint32_t>(value.render_target_write_mask[i]));
+			}
+			write(value.srgb_write_enable);
+			write(value.stencil_enable);
+			write(static_cast<uint32_t>(value.stencil_read_mask));
+			write(static_cast<uint32_t>(value.stencil_write_mask));
+			write(static_cast<uint32_t>(value.stencil_reference_value));
+			write(static_cast<uint32_t>(value.stencil_comparison_func));
+			write(static_cast<uint32_t>(value.stencil_pass_op));
+			write(static_cast<uint32_t>(value.stencil_fail_op));
+			write(static_cast<uint32_t>(value.stencil_depth_fail_op));
+			write(static_cast<uint32_t>(value.topology));
+			write(value.num_vertices);
+			write(value.viewport_width);
+			write(value.viewport_height);
+			write(value.viewport_dispatch_z);
+			write(value.texture_bindings);
+			write(value.sampler_bindings);
+			write(value.storage_bindings);
+		}
+		void write(const technique &value)
+		{
+			write(value.name);
+			write(value.passes);
+			write(value.annotations);
+		}
+		void write(const std::pair<std::string, shader_type> &value)
+		{
+			write(value.first);
+			write(static_cast<uint32_t>(value.second));
+		}
+		template <typename T>
+		void write(const std::vector<T> &values)
+		{
+			write(static_cast<uint32_t>(values.size()));
+			for (const T &value : values)
+				write(value);
+		}
+
+		std::string &data;
+	};
+
+	struct module_reader
+	{
+		module_reader(const std::string &data, size_t offset) : data(data), offset(offset) {}
+
+		bool read_raw(void *value, size_t size)
+		{
+			if (size > data.size() - offset)
+				return false;
+			std::memcpy(value, data.data() + offset, size);
+			offset += size;
+			return true;
+		}
+
+		bool read(uint32_t &value)
+		{
+			return read_raw(&value, sizeof(value));
+		}
+		bool read(uint64_t &value)
+		{
+			return read_raw(&value, sizeof(value));
+		}
+		bool read(float &value)
+		{
+			return read_raw(&value, sizeof(value));
+		}
+		bool read(bool &value)
+		{
+			char byte = '\0';
+			if (!read_raw(&byte, sizeof(byte)))
+				return false;
+			value = byte != '\0';
+			return true;
+		}
+		bool read(std::string &value)
+		{
+			uint32_t size = 0;
+			if (!read(size) || size > data.size() - offset)
+				return false;
+			value.assign(data.data() + offset, size);
+			offset += size;
+			return true;
+		}
+		bool read(type &value)
+		{
+			uint32_t base = 0, rows = 0, cols = 0, qualifiers = 0;
+			if (!read(base) || !read(rows) || !read(cols) || !read(qualifiers) || !read(value.array_length) || !read(value.struct_definition))
+				return false;
+			value.base = static_cast<type::datatype>(base);
+			value.rows = rows;
+			value.cols = cols;
+			value.qualifiers = qualifiers;
+			return true;
+		}
+		bool read(constant &value)
+		{
+			return read_raw(value.as_uint, sizeof(value.as_uint)) && read(value.string_data) && read(value.array_data);
+		}
+		bool read(annotation &value)
+		{
+			return read(value.type) && read(value.name) && read(value.value);
+		}
+		bool read(texture &value)
+		{
+			return read(value.width) && read(value.height) && read_as(value.depth) && read_as(value.levels) && read_as(value.type) && read_as(value.format) &&
+				read(value.id) && read(value.name) && read(value.unique_name) && read(value.semantic) && read(value.annotations) &&
+				read(value.render_target) && read(value.storage_access) && read(value.semantic_binding);
+		}
+		bool read(sampler &value)
+		{
+			return read_as(value.filter) && read_as(value.address_u) && read_as(value.address_v) && read_as(value.address_w) &&
+				read(value.min_lod) && read(value.max_lod) && read(value.lod_bias) &&
+				read(value.type) && read(value.id) && read(value.name) && read(value.unique_name) && read(value.texture_name) && read(value.annotations) && read(value.srgb);
+		}
+		bool read(storage &value)
+		{
+			return read_as(value.level) && read(value.type) && read(value.id) && read(value.name) && read(value.unique_name) && read(value.texture_name);
+		}
+		bool read(uniform &value)
+		{
+			return read(value.type) && read(value.name) && read(value.unique_name) && read(value.size) && read(value.offset) && read(value.annotations) &&
+				read(value.has_initializer_value) && read(value.initializer_value);
+		}
+		bool read(texture_binding &value)
+		{
+			return read_index(value.index) && read(value.entry_point_binding) && read(value.srgb);
+		}
+		bool read(sampler_binding &value)
+		{
+			return read_index(value.index) && read(value.entry_point_binding);
+		}
+		bool read(storage_binding &value)
+		{
+			return read_index(value.index) && read(value.entry_point_binding);
+		}
+		bool read(pass &value)
+		{
+			if (!read(value.name))
+				return false;
+			for (std::string &render_target_name : value.render_target_names)
+				if (!read(render_target_name))
+					return false;
+			if (!read(value.vs_entry_point) || !read(value.ps_entry_point) || !read(value.cs_entry_point) ||
+				!read(value.generate_mipmaps) || !read(value.clear_render_targets))
+				return false;
+			for (int i = 0; i < 8; ++i)
+			{
+				if (!read(value.blend_enable[i]) ||
+					!read_as(value.source_color_blend_factor[i]) || !read_as(value.dest_color_blend_factor[i]) || !read_as(value.color_blend_op[i]) ||
+					!read_as(value.source_alpha_blend_factor[i]) || !read_as(value.dest_alpha_blend_factor[i]) || !read_as(value.alpha_blend_op[i]) ||
+					!read_as(value.render_target_write_mask[i]))
+					return false;
+			}
+			return read(value.srgb_write_enable) && read(value.stencil_enable) &&
+				read_as(value.stencil_read_mask) && read_as(value.stencil_write_mask) && read_as(value.stencil_reference_value) &&
+				read_as(value.stencil_comparison_func) && read_as(value.stencil_pass_op) && read_as(value.stencil_fail_op) && read_as(value.stencil_depth_fail_op) &&
+				read_as(value.topology) && read(value.num_vertices) && read(value.viewport_width) && read(value.viewport_height) && read(value.viewport_dispatch_z) &&
+				read(value.texture_bindings) && read(value.sampler_bindings) && read(value.storage_bindings);
+		}
+		bool read(technique &value)
+		{
+			return read(value.name) && read(value.passes) && read(value.annotations);
+		}
+		bool read(std::pair<std::string, shader_type> &value)
+		{
+			return read(value.first) && read_as(value.second);
+		}
+		template <typename T>
+		bool read(std::vector<T> &values)
+		{
+			uint32_t count = 0;
+			// Every element takes up at least one byte, so this catches corrupted counts before allocating memory for them
+			if (!read(count) || count > data.size() - offset)
+				return false;
+			values.resize(count);
+			for (T &value : values)
+				if (!read(value))
+					return false;
+			return true;
+		}
+
+		// Reads an integer or enumeration value that was widened to 32 bit on write
+		template <typename T>
+		bool read_as(T &value)
+		{
+			uint32_t temp = 0;
+			if (!read(temp))
+				return false;
+			value = static_cast<T>(temp);
+			return true;
+		}
+		// Reads an index that was widened to 64 bit on write
+		bool read_index(size_t &value)
+		{
+			uint64_t temp = 0;
+			if (!read(temp))
+				return false;
+			value = static_cast<size_t>(temp);
+			return true;
+		}
+
+		const std::string &data;
+		size_t offset;
+	};
+}
+
+void reshadefx::serialize_module(const effect_module &module, std::string &data)
+{
+	module_writer writer(data);
+	writer.write(s_module_magic);
+	writer.write(s_module_version);
+
+	writer.write(module.textures);
+	writer.write(module.samplers);
+	writer.write(module.storages);
+	writer.write(module.uniforms);
+	writer.write(module.spec_constants);
+	writer.write(module.total_uniform_size);
+	writer.write(module.techniques);
+	writer.write(module.entry_points);
+}
+
+bool reshadefx::deserialize_module(const std::string &data, size_t &offset, effect_module &module)
+{
+	if (offset > data.size())
+		return false;
+
+	module_reader reader(data, offset);
+
+	uint32_t magic = 0, version = 0;
+	if (!reader.read(magic) || magic != s_module_magic || !reader.read(version) || version != s_module_version)
+		return false;
+
+	effect_module result;
+	if (!reader.read(result.textures) ||
+		!reader.read(result.samplers) ||
+		!reader.read(result.storages) ||
+		!reader.read(result.uniforms) ||
+		!reader.read(result.spec_constants) ||
+		!reader.read(result.total_uniform_size) ||
+		!reader.read(result.techniques) ||
+		!reader.read(result.entry_points))
+		return false;
+
+	module = std::move(result);
+	offset = reader.offset;
+	return true;
+}
@@ -418,4 +418,15 @@ namespace reshadefx
 		std::vector<technique> techniques;
 		std::vector<std::pair<std::string, shader_type>> entry_points;
 	};
+
+	/// <summary>
+	/// Appends a versioned binary representation of the specified effect <paramref name="module"/> to <paramref name="data"/>, so that it can be restored later without parsing the effect code again.
+	/// </summary>
+	void serialize_module(const effect_module &module, std::string &data);
+	/// <summary>
+	/// Restores an effect <paramref name="module"/> from binary data previously written by <see cref="serialize_module"/>, starting at <paramref name="offset"/>.
+	/// </summary>
+	/// <param name="offset">Offset into <paramref name="data"/> to start reading at, which is advanced past the module on success.</param>
+	/// <returns><see langword="true"/> if the data was valid and written by the same version of the serializer, <see langword="false"/> otherwise.</returns>
+	bool deserialize_module(const std::string &data, size_t &offset, effect_module &module);
 }
@@ -26,6 +26,13 @@ namespace reshadefx
 		/// <param name="backend">Code generation implementation to use.</param>
 		/// <returns><see langword="true"/> if parsing was successfull, <see langword="false"/> otherwise.</returns>
 		bool parse(std::string source, class codegen *backend);
+		/// <summary>
+		/// Parses source code from the provided stream as it becomes available and generate code for it.
+		/// </summary>
+		/// <param name="stream">Stream to read source code from, which may still be written to by another thread (e.g. the preprocessor) until it is closed.</param>
+		/// <param name="backend">Code generation implementation to use.</param>
+		/// <returns><see langword="true"/> if parsing was successfull, <see langword="false"/> otherwise.</returns>
+		bool parse(class source_stream &stream, class codegen *backend);
 
 		/// <summary>
 		/// Gets the list of error messages.
@@ -33,6 +40,8 @@ namespace reshadefx
 		const std::string &errors() const { return _errors; }
 
 	private:
+		bool parse(class codegen *backend);
+
 		void error(const location &location, unsigned int code, const std::string &message);
 		void warning(const location &location, unsigned int code, const std::string &message);
 
@@ -84,5 +93,7 @@ namespace reshadefx
 
 		std::vector<uint32_t> _loop_break_target_stack;
 		std::vector<uint32_t> _loop_continue_target_stack;
+
+		parser_arena _arena;
 	};
 }
@@ -45,6 +45,9 @@ void reshadefx::parser::warning(const location &location, unsigned int code, con
 void reshadefx::parser::backup()
 {
 	_token_backup = _token_next;
+
+	// Only the most recent backup is ever restored, so input before it is no longer needed when parsing from a stream
+	_lexer->discard_input_before(_token_backup.offset + _token_backup.length);
 }
 void reshadefx::parser::restore()
 {
@@ -110,7 +113,7 @@ bool reshadefx::parser::accept_symbol(std::string &identifier, scoped_symbol &sy
 	}
 
 	// Figure out which scope to start searching in
-	scope scope = { "::", 0, 0 };
+	scope scope = { 0, 0, 0 };
 	if (!exclusive)
 		scope = current_scope();
 
@@ -27,8 +27,35 @@ private:
 bool reshadefx::parser::parse(std::string source, codegen *backend)
 {
 	_lexer = new lexer(std::move(source));
+
+	const bool parse_success = parse(backend);
+
+	delete _lexer;
+
+	return parse_success;
+}
+bool reshadefx::parser::parse(source_stream &stream, codegen *backend)
+{
+	_lexer = new lexer(std::string());
+	_lexer->set_input_stream(&stream);
+
+	const bool parse_success = parse(backend);
+
+	// Parsing may have stopped early, so drain the rest of the stream too, so that it does not keep collecting what is still being written to it
+	for (std::string remaining; stream.read(remaining);)
+		remaining.clear();
+
+	delete _lexer;
+
+	return parse_success;
+}
+bool reshadefx::parser::parse(codegen *backend)
+{
 	_codegen = backend;
 
+	// Temporary expressions are only used while parsing, so serve their allocations from the arena of this parser
+	const parser_arena::scope arena_scope(_arena);
+
 	consume();
 
 	bool parse_success = true;
@@ -48,8 +75,6 @@ bool reshadefx::parser::parse(std::string source, codegen *backend)
 		}
 	}
 
-	delete _lexer;
-
 	if (parse_success)
 	{
 		backend->optimize_bindings();
@@ -1080,7 +1105,7 @@ bool reshadefx::parser::parse_struct()
 	else
 		info.name = "_anonymous_struct_" + std::to_string(struct_location.line) + '_' + std::to_string(struct_location.column);
 
-	info.unique_name = 'S' + current_scope().name + info.name;
+	info.unique_name = 'S' + current_scope_name() + info.name;
 	std::replace(info.unique_name.begin(), info.unique_name.end(), ':', '_');
 
 	if (!expect('{'))
@@ -1253,7 +1278,7 @@ bool reshadefx::parser::parse_function(type type, std::string name, shader_type
 
 	function info;
 	info.name = name;
-	info.unique_name = 'F' + current_scope().name + name;
+	info.unique_name = 'F' + current_scope_name() + name;
 	std::replace(info.unique_name.begin(), info.unique_name.end(), ':', '_');
 
 	info.return_type = type;
@@ -1898,7 +1923,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 		texture_info.type = static_cast<texture_type>(type.texture_dimension());
 
 		// Add namespace scope to avoid name clashes
-		texture_info.unique_name = 'V' + current_scope().name + name;
+		texture_info.unique_name = 'V' + current_scope_name() + name;
 		std::replace(texture_info.unique_name.begin(), texture_info.unique_name.end(), ':', '_');
 
 		texture_info.annotations = std::move(sampler_info.annotations);
@@ -1968,7 +1993,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 		sampler_info.type = type;
 
 		// Add namespace scope to avoid name clashes
-		sampler_info.unique_name = 'V' + current_scope().name + name;
+		sampler_info.unique_name = 'V' + current_scope_name() + name;
 		std::replace(sampler_info.unique_name.begin(), sampler_info.unique_name.end(), ':', '_');
 
 		const codegen::id id = _codegen->define_sampler(variable_location, texture_info, sampler_info);
@@ -2029,7 +2054,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 		storage_info.type = type;
 
 		// Add namespace scope to avoid name clashes
-		storage_info.unique_name = 'V' + current_scope().name + name;
+		storage_info.unique_name = 'V' + current_scope_name() + name;
 		std::replace(storage_info.unique_name.begin(), storage_info.unique_name.end(), ':', '_');
 
 		if (storage_info.level > texture_info.levels - 1)
@@ -2048,7 +2073,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 		uniform_info.type = type;
 
 		// Add namespace scope to avoid name clashes
-		uniform_info.unique_name = 'V' + current_scope().name + name;
+		uniform_info.unique_name = 'V' + current_scope_name() + name;
 		std::replace(uniform_info.unique_name.begin(), uniform_info.unique_name.end(), ':', '_');
 
 		uniform_info.annotations = std::move(sampler_info.annotations);
@@ -2063,7 +2088,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 	else
 	{
 		// Update global variable names to contain the namespace scope to avoid name clashes
-		std::string unique_name = global ? 'V' + current_scope().name + name : name;
+		std::string unique_name = global ? 'V' + current_scope_name() + name : name;
 		std::replace(unique_name.begin(), unique_name.end(), ':', '_');
 
 		symbol = { symbol_type::variable, 0, type };
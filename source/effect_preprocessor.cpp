@@ -8,7 +8,7 @@
 #include <limits>
 #include <cstdio> // fclose, fopen, fread, fseek
 #include <cassert>
-#include <algorithm> // std::find_if
+#include <algorithm> // std::find_if, std::none_of
 
 #ifndef _WIN32
 	// On Linux systems the native path encoding is UTF-8 already, so no conversion necessary
@@ -107,6 +107,40 @@ static std::string escape_string(std::string s)
 	return '\"' + s + '\"';
 }
 
+struct reshadefx::preprocessor::include_snapshot
+{
+	struct macro_state
+	{
+		std::string name;
+		bool defined;
+		macro definition;
+	};
+	struct file_state
+	{
+		std::string path;
+		bool cached;
+		std::string source_code;
+	};
+
+	std::string source_code;
+	// State of all macros and files that were looked up while preprocessing the include file, before it changed them
+	std::vector<macro_state> macro_dependencies;
+	std::vector<file_state> file_dependencies;
+	// State of all macros and files the include file changed, after preprocessing it
+	std::vector<macro_state> macro_changes;
+	std::vector<std::pair<std::string, std::string>> file_changes;
+	std::vector<std::string> used_macros;
+	std::string output, errors;
+};
+struct reshadefx::preprocessor::include_recording
+{
+	include_snapshot snapshot;
+	std::unordered_set<std::string> recorded_macros, changed_macros;
+	std::unordered_set<std::string> recorded_files, changed_files;
+	// Files that were being preprocessed by the including instance, so that recursive includes are still detected
+	std::vector<std::string> outer_files;
+};
+
 reshadefx::preprocessor::preprocessor()
 {
 }
@@ -122,17 +156,14 @@ void reshadefx::preprocessor::add_include_path(const std::filesystem::path &path
 bool reshadefx::preprocessor::add_macro_definition(const std::string &name, const macro &definition)
 {
 	assert(!name.empty());
+	record_macro_lookup(name);
+	record_macro_change(name);
+
 	const auto insert = _macros.emplace(name, definition);
 	if (insert.second)
 		return true;
 	// Allow redefinition of identical macros
-	const macro &existing_definition = insert.first->second;
-	return
-		existing_definition.replacement_list == definition.replacement_list &&
-		existing_definition.parameters == definition.parameters &&
-		existing_definition.is_predefined == definition.is_predefined &&
-		existing_definition.is_variadic == definition.is_variadic &&
-		existing_definition.is_function_like == definition.is_function_like;
+	return insert.first->second == definition;
 }
 
 bool reshadefx::preprocessor::append_file(const std::filesystem::path &path)
@@ -158,6 +189,9 @@ bool reshadefx::preprocessor::append_string(std::string source_code, const std::
 	push(std::move(source_code), path.empty() ? "unknown" : path.u8string());
 	parse();
 
+	if (_output_stream != nullptr)
+		flush_output();
+
 	return _errors.find(": preprocessor error: ", errors_offset) == std::string::npos;
 }
 
@@ -221,9 +255,24 @@ void reshadefx::preprocessor::push(std::string input, const std::string &name)
 	level.next_token.id = tokenid::unknown;
 	level.next_token.location = start_location; // This is used in 'consume' to initialize the output location
 
-	// Inherit hidden macros from parent
-	if (!_input_stack.empty())
-		level.hidden_macros = _input_stack.back().hidden_macros;
+	_input_stack.push_back(std::move(level));
+	_next_input_index = _input_stack.size() - 1;
+
+	// Advance into the input stack to update next token
+	consume();
+}
+void reshadefx::preprocessor::push(std::shared_ptr<const token_list> input, size_t first_token_index, size_t end_token_index)
+{
+	input_level level;
+	level.next_token_index = first_token_index;
+	level.end_token_index = end_token_index;
+	level.tokens = std::move(input);
+	// Tokens are reported at the location they were pushed at, same as for an unnamed string
+	level.tokens_location = _token.location;
+	level.next_token.id = tokenid::unknown;
+	level.next_token.location = level.tokens_location;
+	level.next_token.offset = 0;
+	level.next_token.length = 0;
 
 	_input_stack.push_back(std::move(level));
 	_next_input_index = _input_stack.size() - 1;
@@ -266,10 +315,50 @@ void reshadefx::preprocessor::consume()
 
 	// Set current token
 	_token = std::move(input.next_token);
-	_current_token_raw_data = input.lexer->input_string().substr(_token.offset, _token.length);
 
 	// Get the next token
-	input.next_token = input.lexer->lex();
+	if (input.lexer != nullptr)
+	{
+		_current_token_raw_data = input.lexer->input_string().substr(_token.offset, _token.length);
+
+		input.next_token = input.lexer->lex();
+	}
+	else
+	{
+		_current_token_raw_data = input.tokens->text.substr(_token.offset, _token.length);
+
+		input.next_token.location = input.tokens_location;
+
+		if (input.next_token_index < input.end_token_index)
+		{
+			const token_list::entry &entry = input.tokens->tokens[input.next_token_index++];
+			input.next_token.id = entry.id;
+			input.next_token.offset = entry.offset;
+			input.next_token.length = entry.length;
+			input.next_token.literal_as_double = entry.literal_as_double;
+
+			switch (entry.id)
+			{
+			case tokenid::identifier:
+				input.next_token.literal_as_string.assign(input.tokens->text, entry.offset, entry.length);
+				break;
+			case tokenid::string_literal:
+				// String literals are not escaped by the preprocessor, so the literal is simply the text between the quotes
+				input.next_token.literal_as_string.assign(input.tokens->text, entry.offset + 1, entry.length - (entry.length > 1 && input.tokens->text[entry.offset + entry.length - 1] == '\"' ? 2 : 1));
+				break;
+			default:
+				input.next_token.literal_as_string.clear();
+				break;
+			}
+		}
+		else
+		{
+			input.next_token.id = tokenid::end_of_file;
+			input.next_token.offset = input.tokens->text.size();
+			input.next_token.length = 0;
+			input.next_token.literal_as_string.clear();
+		}
+	}
 
 	// Verify string literals (since the lexer cannot throw errors itself)
 	if (_token == tokenid::string_literal && _current_token_raw_data.back() != '\"')
@@ -337,7 +426,8 @@ bool reshadefx::preprocessor::expect(tokenid tokid)
 		}
 		else
 		{
-			const std::string token_string = _input_stack[_next_input_index].lexer->input_string().substr(actual_token.offset, actual_token.length);
+			const input_level &input = _input_stack[_next_input_index];
+			const std::string token_string = (input.lexer != nullptr ? input.lexer->input_string() : input.tokens->text).substr(actual_token.offset, actual_token.length);
 			error(actual_token.location, "syntax error: unexpected token '" + token_string + '\'');
 		}
 
@@ -354,6 +444,10 @@ void reshadefx::preprocessor::parse()
 	// Consume all tokens in the input
 	while (!peek(tokenid::end_of_file))
 	{
+		// Fast-forward through the lines of a disabled section up to the next conditional directive, instead of lexing them token by token
+		if (!_if_stack.empty() && _if_stack.back().skipping && peek(tokenid::end_of_line) && _input_stack[_next_input_index].lexer != nullptr)
+			_input_stack[_next_input_index].lexer->skip_to_next_conditional_directive();
+
 		consume();
 
 		_recursion_count = 0;
@@ -450,6 +544,9 @@ void reshadefx::preprocessor::parse()
 			_output += line;
 			_output += '\n';
 			line.clear();
+			// Hand off output in larger chunks, to avoid waking up the reading thread for every line
+			if (_output_stream != nullptr && _output.size() - _output_flushed >= 64 * 1024)
+				flush_output();
 			continue;
 		case tokenid::identifier:
 			if (evaluate_identifier_as_macro())
@@ -510,6 +607,9 @@ void reshadefx::preprocessor::parse_undef()
 	if (_token.literal_as_string == "defined")
 		return warning(_token.location, "macro name 'defined' is reserved");
 
+	record_macro_change(_token.literal_as_string);
+
+	_macro_tokens.erase(_token.literal_as_string);
 	_macros.erase(_token.literal_as_string);
 }
 
@@ -700,6 +800,7 @@ void reshadefx::preprocessor::parse_pragma()
 		if (const auto file_it = _file_cache.find(_output_location.source);
 			file_it != _file_cache.end())
 		{
+			record_file_change(file_it->first);
 			file_it->second.clear();
 		}
 		return;
@@ -745,7 +846,8 @@ void reshadefx::preprocessor::parse_include()
 	if (std::find_if(_input_stack.begin(), _input_stack.end(),
 			[&file_path_string](const input_level &level) {
 				return level.name == file_path_string;
-			}) != _input_stack.end())
+			}) != _input_stack.end() ||
+		(_recording != nullptr && std::find(_recording->outer_files.begin(), _recording->outer_files.end(), file_path_string) != _recording->outer_files.end()))
 		return error(_token.location, "recursive #include");
 
 	std::string input;
@@ -754,12 +856,17 @@ void reshadefx::preprocessor::parse_include()
 		file_it != _file_cache.end())
 	{
 		input = file_it->second;
+
+		record_file_lookup(file_path_string, true, input);
 	}
 	else
 	{
 		if (!read_file(file_path, input))
 			return error(keyword_location, "could not open included file '" + file_name.u8string() + '\'');
 
+		record_file_lookup(file_path_string, false, input);
+		record_file_change(file_path_string);
+
 		_file_cache.emplace(file_path_string, input);
 	}
 
@@ -767,6 +874,17 @@ void reshadefx::preprocessor::parse_include()
 	if (!expect(tokenid::end_of_line))
 		consume_until(tokenid::end_of_line);
 
+	// Use the result of a previous preprocessing of this file with the same macro state if possible, instead of preprocessing it again
+	if (_include_cache != nullptr && !input.empty())
+	{
+		std::shared_ptr<const include_snapshot> snapshot = find_include_snapshot(file_path_string, input);
+		if (snapshot == nullptr)
+			snapshot = record_include_snapshot(file_path_string, input);
+
+		apply_include_snapshot(*snapshot, file_path_string);
+		return;
+	}
+
 	// Clear out input stack before pushing include, so that hidden macros do not bleed into the include
 	while (_input_stack.size() > (_next_input_index + 1))
 		_input_stack.pop_back();
@@ -774,6 +892,150 @@ void reshadefx::preprocessor::parse_include()
 	push(std::move(input), file_path_string);
 }
 
+std::shared_ptr<const reshadefx::preprocessor::include_snapshot> reshadefx::preprocessor::find_include_snapshot(const std::string &path, const std::string &source_code) const
+{
+	std::vector<std::shared_ptr<const include_snapshot>> snapshots;
+	{
+		const std::lock_guard<std::mutex> lock(_include_cache->_mutex);
+
+		if (const auto it = _include_cache->_snapshots.find(path);
+			it != _include_cache->_snapshots.end())
+			snapshots = it->second;
+	}
+
+	for (const std::shared_ptr<const include_snapshot> &snapshot : snapshots)
+	{
+		if (snapshot->source_code != source_code)
+			continue;
+
+		// The snapshot is only valid if every macro and file it looked up is in the same state now as it was when it was recorded
+		if (std::all_of(snapshot->macro_dependencies.begin(), snapshot->macro_dependencies.end(),
+				[this](const include_snapshot::macro_state &dependency) {
+					const auto macro_it = _macros.find(dependency.name);
+					return macro_it != _macros.end() ? dependency.defined && macro_it->second == dependency.definition : !dependency.defined;
+				}) &&
+			std::all_of(snapshot->file_dependencies.begin(), snapshot->file_dependencies.end(),
+				[this](const include_snapshot::file_state &dependency) {
+					const auto file_it = _file_cache.find(dependency.path);
+					return file_it != _file_cache.end() ? file_it->second == dependency.source_code : !dependency.cached;
+				}))
+			return snapshot;
+	}
+
+	return nullptr;
+}
+std::shared_ptr<const reshadefx::preprocessor::include_snapshot> reshadefx::preprocessor::record_include_snapshot(const std::string &path, const std::string &source_code)
+{
+	// Preprocess the include file in a separate instance that starts with the same state as this one and keeps track of everything the file depends on
+	preprocessor pp;
+	pp._include_paths = _include_paths;
+	pp._macros = _macros;
+	pp._file_cache = _file_cache;
+	pp._recording = std::make_unique<include_recording>();
+	for (const input_level &level : _input_stack)
+		if (!level.name.empty())
+			pp._recording->outer_files.push_back(level.name);
+
+	pp.append_string(source_code, std::filesystem::u8path(path));
+
+	const std::shared_ptr<include_snapshot> snapshot = std::make_shared<include_snapshot>(std::move(pp._recording->snapshot));
+	snapshot->source_code = source_code;
+
+	for (const std::string &name : pp._recording->changed_macros)
+	{
+		const auto macro_it = pp._macros.find(name);
+		snapshot->macro_changes.push_back({ name, macro_it != pp._macros.end(), macro_it != pp._macros.end() ? macro_it->second : macro() });
+	}
+	for (const std::string &file_path : pp._recording->changed_files)
+		snapshot->file_changes.emplace_back(file_path, pp._file_cache.at(file_path));
+
+	snapshot->used_macros.assign(pp._used_macros.begin(), pp._used_macros.end());
+	snapshot->output = std::move(pp._output);
+	// Remove the line feed that is appended after the end of input, since the including file continues after this
+	if (!snapshot->output.empty() && snapshot->output.back() == '\n')
+		snapshot->output.pop_back();
+	snapshot->errors = std::move(pp._errors);
+
+	{
+		const std::lock_guard<std::mutex> lock(_include_cache->_mutex);
+
+		// Limit the number of variants kept per file, in case it is included with lots of different macro states
+		std::vector<std::shared_ptr<const include_snapshot>> &snapshots = _include_cache->_snapshots[path];
+		if (snapshots.size() < 8)
+			snapshots.push_back(snapshot);
+	}
+
+	return snapshot;
+}
+void reshadefx::preprocessor::apply_include_snapshot(const include_snapshot &snapshot, const std::string &path)
+{
+	for (const include_snapshot::macro_state &change : snapshot.macro_changes)
+	{
+		_macro_tokens.erase(change.name);
+
+		if (change.defined)
+			_macros[change.name] = change.definition;
+		else
+			_macros.erase(change.name);
+	}
+
+	for (const std::pair<std::string, std::string> &change : snapshot.file_changes)
+		_file_cache[change.first] = change.second;
+
+	_used_macros.insert(snapshot.used_macros.begin(), snapshot.used_macros.end());
+
+	_output += snapshot.output;
+	_errors += snapshot.errors;
+
+	// The output ends in the include file, so make sure a line directive back to the including file is added with the next token
+	_output_location.source = path;
+}
+
+void reshadefx::preprocessor::flush_output()
+{
+	assert(_output_stream != nullptr && (_output.size() == _output_flushed || _output.back() == '\n'));
+
+	_output_stream->write(std::string_view(_output).substr(_output_flushed));
+
+	if (_keep_output)
+		_output_flushed = _output.size();
+	else
+		_output.clear();
+}
+
+void reshadefx::preprocessor::record_macro_lookup(const std::string &name)
+{
+	if (_recording == nullptr || !_recording->recorded_macros.insert(name).second)
+		return;
+
+	const auto macro_it = _macros.find(name);
+	_recording->snapshot.macro_dependencies.push_back({ name, macro_it != _macros.end(), macro_it != _macros.end() ? macro_it->second : macro() });
+}
+void reshadefx::preprocessor::record_macro_change(const std::string &name)
+{
+	if (_recording == nullptr)
+		return;
+
+	// Any later lookups see the changed state, so they do not depend on the state before the include file
+	_recording->recorded_macros.insert(name);
+	_recording->changed_macros.insert(name);
+}
+void reshadefx::preprocessor::record_file_lookup(const std::string &path, bool cached, const std::string &source_code)
+{
+	if (_recording == nullptr || !_recording->recorded_files.insert(path).second)
+		return;
+
+	_recording->snapshot.file_dependencies.push_back({ path, cached, source_code });
+}
+void reshadefx::preprocessor::record_file_change(const std::string &path)
+{
+	if (_recording == nullptr)
+		return;
+
+	_recording->recorded_files.insert(path);
+	_recording->changed_files.insert(path);
+}
+
 bool reshadefx::preprocessor::evaluate_expression()
 {
 	struct rpn_token
@@ -1146,31 +1408,38 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 		return true;
 	}
 
+	record_macro_lookup(_token.literal_as_string);
+
 	const auto macro_it = _macros.find(_token.literal_as_string);
 	if (macro_it == _macros.end())
 		return false;
 
 	if (!_input_stack.empty())
 	{
-		const std::unordered_set<std::string> &hidden_macros = _input_stack[_current_input_index].hidden_macros;
-		if (hidden_macros.find(_token.literal_as_string) != hidden_macros.end())
-			return false;
+		// Levels below the current one are the ones it was pushed from, so walk down the stack to find out which macros are hidden
+		for (size_t input_index = 0; input_index <= _current_input_index; ++input_index)
+			if (_input_stack[input_index].hidden_macro == _token.literal_as_string)
+				return false;
 	}
 
 	const location macro_location = _token.location;
 	if (_recursion_count++ >= 256)
 		return error(macro_location, "macro recursion too high"), false;
 
-	std::vector<std::string> arguments;
+	// Keep the tokens of all arguments in a single list, so that they do not have to be lexed again during argument prescan
+	std::shared_ptr<token_list> arguments;
+	std::vector<size_t> argument_indices;
 	if (macro_it->second.is_function_like)
 	{
 		if (!accept(tokenid::parenthesis_open))
 			return false; // Function like macro used without arguments, handle that like a normal identifier instead
 
+		arguments = std::make_shared<token_list>();
+
 		while (true)
 		{
 			int parentheses_level = 0;
-			std::string argument;
+			const size_t argument_index = arguments->tokens.size();
 
 			// Ignore whitespace preceding the argument
 			accept(tokenid::space);
@@ -1186,38 +1455,58 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 				// Consume all tokens of the argument
 				consume();
 
-				if (_token == tokenid::comma && parentheses_level == 0 && !(macro_it->second.is_variadic && arguments.size() == macro_it->second.parameters.size()))
+				if (_token == tokenid::comma && parentheses_level == 0 && !(macro_it->second.is_variadic && argument_indices.size() == macro_it->second.parameters.size()))
 					break; // Comma marks end of an argument (unless this is the last argument in a variadic macro invocation)
 				if (_token == tokenid::parenthesis_open)
 					parentheses_level++;
 				if (_token == tokenid::parenthesis_close && --parentheses_level < 0)
 					break;
 
+				token_list::entry argument_token;
+				argument_token.id = _token.id;
+				argument_token.literal_as_double = _token.literal_as_double;
+
 				// Collapse all whitespace down to a single space
 				if (_token == tokenid::space)
-					argument += ' ';
+				{
+					if (arguments->tokens.size() != argument_index && arguments->tokens.back().id != tokenid::space)
+						arguments->append(argument_token, " ");
+				}
 				else
-					argument += _current_token_raw_data;
+				{
+					arguments->append(argument_token, _current_token_raw_data);
+				}
 			}
 
 			// Trim whitespace following the argument
-			if (argument.size() && argument.back() == ' ')
-				argument.pop_back();
+			if (arguments->tokens.size() != argument_index && arguments->tokens.back().id == tokenid::space)
+			{
+				arguments->tokens.pop_back();
+				arguments->text.pop_back();
+			}
 
-			arguments.push_back(std::move(argument));
+			// Terminate the argument with an empty marker token, so that argument prescan knows where to stop
+			token_list::entry end_token;
+			end_token.id = tokenid::unknown;
+			end_token.literal_as_double = 0;
+			arguments->append(end_token, std::string_view());
+
+			argument_indices.push_back(argument_index);
 
 			if (parentheses_level < 0)
 				break;
 		}
 	}
 
-	expand_macro(macro_it->first, macro_it->second, arguments);
+	expand_macro(macro_it->first, macro_it->second, arguments, argument_indices);
 
 	return true;
 }
 
-bool reshadefx::preprocessor::is_defined(const std::string &name) const
+bool reshadefx::preprocessor::is_defined(const std::string &name)
 {
+	record_macro_lookup(name);
+
 	return _macros.find(name) != _macros.end() ||
 		// Check built-in macros as well
 		name == "__LINE__" ||
@@ -1228,17 +1517,108 @@ bool reshadefx::preprocessor::is_defined(const std::string &name) const
 		name == "__FILE_NAME_HASH__";
 }
 
-void reshadefx::preprocessor::expand_macro(const std::string &name, const macro &definition, const std::vector<std::string> &arguments)
+void reshadefx::preprocessor::expand_macro(const std::string &name, const macro &definition, const std::shared_ptr<const token_list> &arguments, const std::vector<size_t> &argument_indices)
 {
 	if (definition.replacement_list.empty())
 		return;
 
 	// Verify argument count for function-like macros
-	if (arguments.size() < definition.parameters.size())
+	if (argument_indices.size() < definition.parameters.size())
 		return warning(_token.location, "not enough arguments for function-like macro invocation '" + name + "'");
-	if (arguments.size() > definition.parameters.size() && !definition.is_variadic)
+	if (argument_indices.size() > definition.parameters.size() && !definition.is_variadic)
 		return warning(_token.location, "too many arguments for function-like macro invocation '" + name + "'");
 
+	// Lex replacement list only once and reuse the tokens for all following expansions of this macro
+	std::shared_ptr<const token_list> replacement_tokens = _macro_tokens[name];
+	if (replacement_tokens == nullptr)
+		_macro_tokens[name] = replacement_tokens = lex_macro_replacement_list(definition.replacement_list);
+
+	// Object-like macros always expand to the same tokens, so can push those directly
+	if (!definition.is_function_like)
+	{
+		push(replacement_tokens, 0, replacement_tokens->tokens.size());
+
+		// Avoid expanding macros again that are referencing themselves
+		_input_stack[_current_input_index].hidden_macro = name;
+		return;
+	}
+
+	// Each argument is terminated by an empty marker token, which is right before the start of the next argument
+	const auto argument_end_index = [&arguments, &argument_indices](size_t index) {
+		return index + 1 < argument_indices.size() ? argument_indices[index + 1] : arguments->tokens.size();
+	};
+	const auto argument_text = [&arguments, &argument_indices, &argument_end_index](size_t index) {
+		const size_t text_offset = arguments->tokens[argument_indices[index]].offset;
+		return std::string_view(arguments->text).substr(text_offset, arguments->tokens[argument_end_index(index) - 1].offset - text_offset);
+	};
+
+	// Function-like macros are expanded by splicing the argument tokens into the replacement list, unless they make use of the ## token concatenation operator, which requires lexing the concatenated text again (see below)
+	if (std::none_of(replacement_tokens->tokens.begin(), replacement_tokens->tokens.end(),
+			[](const token_list::entry &tok) { return tok.id == tokenid::unknown && tok.length == 0 && static_cast<char>(tok.literal_as_uint >> 8) == macro_replacement_concat; }))
+	{
+		const auto output = std::make_shared<token_list>();
+		output->text.reserve(replacement_tokens->text.size());
+		output->tokens.reserve(replacement_tokens->tokens.size());
+
+		for (const token_list::entry &tok : replacement_tokens->tokens)
+		{
+			if (tok.id != tokenid::unknown || tok.length != 0)
+			{
+				output->append(tok, std::string_view(replacement_tokens->text).substr(tok.offset, tok.length));
+				continue;
+			}
+
+			// This is a special replacement sequence
+			const char type = static_cast<char>(tok.literal_as_uint >> 8);
+			const size_t index = tok.literal_as_uint & 0xFF;
+
+			token_list::entry string_token;
+			string_token.id = tokenid::string_literal;
+			string_token.literal_as_double = 0;
+
+			if (index >= argument_indices.size())
+			{
+				if (definition.is_variadic && type == macro_replacement_stringize)
+					output->append(string_token, "\"\"");
+				continue;
+			}
+
+			switch (type)
+			{
+			case macro_replacement_argument:
+				// Argument prescan
+				push(arguments, argument_indices[index], argument_end_index(index));
+				while (true)
+				{
+					// Consume all tokens of the argument (until the end marker is reached)
+					consume();
+
+					if (_token == tokenid::unknown)
+						break;
+					if (_token == tokenid::identifier && evaluate_identifier_as_macro())
+						continue;
+
+					token_list::entry argument_token;
+					argument_token.id = _token.id;
+					argument_token.literal_as_double = _token.literal_as_double;
+					output->append(argument_token, _current_token_raw_data);
+				}
+				assert(_current_token_raw_data.empty());
+				break;
+			case macro_replacement_stringize:
+				// Adds backslashes to escape quotes
+				output->append(string_token, escape_string<'\"'>(std::string(argument_text(index))));
+				break;
+			}
+		}
+
+		push(output, 0, output->tokens.size());
+
+		// Avoid expanding macros again that are referencing themselves
+		_input_stack[_current_input_index].hidden_macro = name;
+		return;
+	}
+
 	std::string input;
 	input.reserve(definition.replacement_list.size());
 
@@ -1253,7 +1633,7 @@ void reshadefx::preprocessor::expand_macro(const std::string &name, const macro
 		// This is a special replacement sequence
 		const char type = definition.replacement_list[++offset];
 		const char index = definition.replacement_list[++offset];
-		if (static_cast<size_t>(index) >= arguments.size())
+		if (static_cast<size_t>(index) >= argument_indices.size())
 		{
 			if (definition.is_variadic)
 			{
@@ -1270,27 +1650,27 @@ void reshadefx::preprocessor::expand_macro(const std::string &name, const macro
 		{
 		case macro_replacement_argument:
 			// Argument prescan
-			push(arguments[index] + static_cast<char>(macro_replacement_argument));
+			push(arguments, argument_indices[index], argument_end_index(index));
 			while (true)
 			{
 				// Consume all tokens of the argument (until the end marker is reached)
 				consume();
 
-				if (_token == tokenid::unknown) // 'macro_replacement_argument' is 'tokenid::unknown'
+				if (_token == tokenid::unknown)
 					break;
 				if (_token == tokenid::identifier && evaluate_identifier_as_macro())
 					continue;
 
 				input += _current_token_raw_data;
 			}
-			assert(_current_token_raw_data[0] == macro_replacement_argument);
+			assert(_current_token_raw_data.empty());
 			break;
 		case macro_replacement_concat:
-			input += arguments[index];
+			input += argument_text(index);
 			break;
 		case macro_replacement_stringize:
 			// Adds backslashes to escape quotes
-			input += escape_string<'\"'>(arguments[index]);
+			input += escape_string<'\"'>(std::string(argument_text(index)));
 			break;
 		}
 	}
@@ -1298,7 +1678,61 @@ void reshadefx::preprocessor::expand_macro(const std::string &name, const macro
 	push(std::move(input));
 
 	// Avoid expanding macros again that are referencing themselves
-	_input_stack[_current_input_index].hidden_macros.insert(name);
+	_input_stack[_current_input_index].hidden_macro = name;
+}
+
+void reshadefx::preprocessor::token_list::append(const entry &tok, std::string_view data)
+{
+	entry &appended_token = tokens.emplace_back(tok);
+	appended_token.offset = text.size();
+	appended_token.length = data.size();
+	text += data;
+}
+
+auto reshadefx::preprocessor::lex_macro_replacement_list(const std::string &replacement_list) -> std::shared_ptr<const token_list>
+{
+	const auto result = std::make_shared<token_list>();
+	result->text.reserve(replacement_list.size());
+
+	for (size_t offset = 0; offset < replacement_list.size();)
+	{
+		if (replacement_list[offset] == macro_replacement_start)
+		{
+			// Special replacement sequences are stored as empty unknown tokens, with the sequence type and argument index encoded in the literal value
+			token_list::entry tok;
+			tok.id = tokenid::unknown;
+			tok.literal_as_uint = (static_cast<unsigned char>(replacement_list[offset + 1]) << 8) | static_cast<unsigned char>(replacement_list[offset + 2]);
+			result->append(tok, std::string_view());
+			offset += 3;
+			continue;
+		}
+
+		size_t end = replacement_list.find(static_cast<char>(macro_replacement_start), offset);
+		if (end == std::string::npos)
+			end = replacement_list.size();
+
+		lexer lexer(
+			replacement_list.substr(offset, end - offset),
+			true  /* ignore_comments */,
+			false /* ignore_whitespace */,
+			false /* ignore_pp_directives */,
+			false /* ignore_line_directives */,
+			true  /* ignore_keywords */,
+			false /* escape_string_literals */,
+			location(1, 2) /* not at the beginning of a line, so that '#' is not mistaken for a directive */);
+
+		for (token tok; (tok = lexer.lex()) != tokenid::end_of_file;)
+		{
+			token_list::entry entry;
+			entry.id = tok.id;
+			entry.literal_as_double = tok.literal_as_double;
+			result->append(entry, lexer.input_string().substr(tok.offset, tok.length));
+		}
+
+		offset = end;
+	}
+
+	return result;
 }
 
 void reshadefx::preprocessor::create_macro_replacement_list(macro &definition)
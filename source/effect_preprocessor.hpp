@@ -7,12 +7,16 @@
 
 #include "effect_token.hpp"
 #include <memory> // std::unique_ptr
+#include <mutex>
 #include <filesystem>
 #include <unordered_map>
 #include <unordered_set>
 
 namespace reshadefx
 {
+	class include_cache;
+	class source_stream;
+
 	/// <summary>
 	/// A C-style preprocessor implementation.
 	/// </summary>
@@ -26,6 +30,11 @@ namespace reshadefx
 			bool is_predefined = false;
 			bool is_variadic = false;
 			bool is_function_like = false;
+
+			friend bool operator==(const macro &lhs, const macro &rhs)
+			{
+				return lhs.replacement_list == rhs.replacement_list && lhs.parameters == rhs.parameters && lhs.is_predefined == rhs.is_predefined && lhs.is_variadic == rhs.is_variadic && lhs.is_function_like == rhs.is_function_like;
+			}
 		};
 
 		// Define constructor explicitly because lexer class is not included here
@@ -70,12 +79,34 @@ namespace reshadefx
 		/// <returns><see langword="true"/> if parsing was successful, <see langword="false"/> otherwise.</returns>
 		bool append_string(std::string source_code, const std::filesystem::path &path = std::filesystem::path());
 
+		/// <summary>
+		/// Makes any following #include of the specified file use the provided contents instead of reading it from disk.
+		/// </summary>
+		/// <param name="path">Path to the file to override.</param>
+		/// <param name="source_code">Contents to use for that file.</param>
+		void override_file(const std::filesystem::path &path, std::string source_code) { _file_cache[path.u8string()] = std::move(source_code); }
+
+		/// <summary>
+		/// Sets a cache of preprocessed include files to look up included files in before preprocessing them again.
+		/// Files that are not found in there yet are added to it after they were preprocessed.
+		/// </summary>
+		/// <param name="cache">Cache to use, or <see langword="nullptr"/> to preprocess every include again.</param>
+		void set_include_cache(include_cache *cache) { _include_cache = cache; }
+		/// <summary>
+		/// Sets a stream to write pre-processed output to in chunks as it is produced, so that it can be consumed (e.g. by the parser on another thread) before preprocessing has finished.
+		/// The output string then only holds what was not written to the stream yet, unless <paramref name="keep_output"/> is set.
+		/// </summary>
+		/// <param name="stream">Stream to write to, or <see langword="nullptr"/> to accumulate all output in the output string.</param>
+		/// <param name="keep_output">Set to <see langword="true"/> to still accumulate all output in the output string too (e.g. to cache it afterwards).</param>
+		void set_output_stream(source_stream *stream, bool keep_output = false) { _output_stream = stream; _keep_output = keep_output; }
+
 		/// <summary>
 		/// Gets the list of error messages.
 		/// </summary>
 		const std::string &errors() const { return _errors; }
 		/// <summary>
 		/// Gets the current pre-processed output string.
+		/// This is empty after an append call returned when an output stream is set without keeping the output (see <see cref="set_output_stream"/>).
 		/// </summary>
 		const std::string &output() const { return _output; }
 
@@ -90,6 +121,11 @@ namespace reshadefx
 		std::vector<std::pair<std::string, std::string>> used_macro_definitions() const;
 
 	private:
+		friend class include_cache;
+
+		struct include_snapshot;
+		struct include_recording;
+
 		struct if_level
 		{
 			bool value;
@@ -97,18 +133,45 @@ namespace reshadefx
 			token pp_token;
 			size_t input_index;
 		};
+		struct token_list
+		{
+			// Compact token representation, the location and literal string are filled in again when the token is consumed
+			struct entry
+			{
+				tokenid id;
+				size_t offset, length; // Offset and length of the raw token data in the text below
+				union
+				{
+					int literal_as_int;
+					unsigned int literal_as_uint;
+					float literal_as_float;
+					double literal_as_double;
+				};
+			};
+
+			void append(const entry &tok, std::string_view data);
+
+			std::string text;
+			std::vector<entry> tokens;
+		};
 		struct input_level
 		{
 			std::string name;
 			std::unique_ptr<class lexer> lexer;
+			// Already lexed input, used instead of the lexer for macro expansions and arguments
+			std::shared_ptr<const token_list> tokens;
+			size_t next_token_index = 0, end_token_index = 0;
+			location tokens_location;
 			token next_token;
-			std::unordered_set<std::string> hidden_macros;
+			// Name of the macro this level is an expansion of, which is hidden in this and all levels pushed on top of it
+			std::string hidden_macro;
 		};
 
 		void error(const location &location, const std::string &message);
 		void warning(const location &location, const std::string &message);
 
 		void push(std::string input, const std::string &name = std::string());
+		void push(std::shared_ptr<const token_list> input, size_t first_token_index, size_t end_token_index);
 
 		bool peek(tokenid tokid) const;
 		void consume();
@@ -133,9 +196,19 @@ namespace reshadefx
 		bool evaluate_expression();
 		bool evaluate_identifier_as_macro();
 
-		bool is_defined(const std::string &name) const;
-		void expand_macro(const std::string &name, const macro &definition, const std::vector<std::string> &arguments);
+		bool is_defined(const std::string &name);
+		void expand_macro(const std::string &name, const macro &definition, const std::shared_ptr<const token_list> &arguments, const std::vector<size_t> &argument_indices);
 		void create_macro_replacement_list(macro &definition);
+		static std::shared_ptr<const token_list> lex_macro_replacement_list(const std::string &replacement_list);
+
+		std::shared_ptr<const include_snapshot> find_include_snapshot(const std::string &path, const std::string &source_code) const;
+		std::shared_ptr<const include_snapshot> record_include_snapshot(const std::string &path, const std::string &source_code);
+		void apply_include_snapshot(const include_snapshot &snapshot, const std::string &path);
+		void record_macro_lookup(const std::string &name);
+		void record_macro_change(const std::string &name);
+		void record_file_lookup(const std::string &path, bool cached, const std::string &source_code);
+		void record_file_change(const std::string &path);
+		void flush_output();
 
 		std::string _output, _errors;
 
@@ -149,10 +222,30 @@ namespace reshadefx
 		unsigned short _recursion_count = 0;
 		std::unordered_set<std::string> _used_macros;
 		std::unordered_map<std::string, macro> _macros;
+		// Replacement lists lexed on first expansion of a macro, so that later expansions can reuse the tokens
+		std::unordered_map<std::string, std::shared_ptr<const token_list>> _macro_tokens;
 
 		std::vector<if_level> _if_stack;
 
 		std::vector<std::filesystem::path> _include_paths;
 		std::unordered_map<std::string, std::string> _file_cache;
+
+		include_cache *_include_cache = nullptr;
+		source_stream *_output_stream = nullptr;
+		bool _keep_output = false;
+		size_t _output_flushed = 0;
+		// Only set while this instance is preprocessing an include file to create a snapshot of it
+		std::unique_ptr<include_recording> _recording;
+	};
+
+	/// <summary>
+	/// A cache of preprocessed include files, which can be shared between preprocessor instances (and threads), so that headers included by many effects are only preprocessed once for every distinct state of the macros they depend on.
+	/// </summary>
+	class include_cache
+	{
+		friend class preprocessor;
+
+		std::mutex _mutex;
+		std::unordered_map<std::string, std::vector<std::shared_ptr<const preprocessor::include_snapshot>>> _snapshots;
 	};
 }
@@ -6,8 +6,9 @@
 #include "effect_symbol_table.hpp"
 #include <cassert>
 #include <malloc.h> // alloca
-#include <algorithm> // std::upper_bound, std::sort
+#include <algorithm> // std::equal_range, std::stable_sort, std::upper_bound, std::sort
 #include <functional> // std::greater
+#include <string_view>
 
 enum class intrinsic_id
 {
@@ -141,6 +142,35 @@ static const intrinsic s_intrinsics[] =
 #undef float3
 #undef float4
 
+// Intrinsics ordered by name and parameter count, so that all overloads for a call can be found with a binary search instead of walking the entire list above
+struct intrinsic_less
+{
+	bool operator()(const intrinsic *lhs, const intrinsic *rhs) const
+	{
+		return operator()(lhs, std::make_pair(std::string_view(rhs->name), rhs->parameter_list.size()));
+	}
+	bool operator()(const intrinsic *lhs, const std::pair<std::string_view, size_t> &rhs) const
+	{
+		const int name_comparison = std::string_view(lhs->name).compare(rhs.first);
+		return name_comparison < 0 || (name_comparison == 0 && lhs->parameter_list.size() < rhs.second);
+	}
+	bool operator()(const std::pair<std::string_view, size_t> &lhs, const intrinsic *rhs) const
+	{
+		const int name_comparison = lhs.first.compare(rhs->name);
+		return name_comparison < 0 || (name_comparison == 0 && lhs.second < rhs->parameter_list.size());
+	}
+};
+
+static const std::vector<const intrinsic *> s_intrinsics_sorted = []() {
+	std::vector<const intrinsic *> sorted;
+	sorted.reserve(std::size(s_intrinsics));
+	for (const intrinsic &intrinsic : s_intrinsics)
+		sorted.push_back(&intrinsic);
+	// Keep declaration order between overloads with the same parameter count, since that decides which one is picked for ambiguous calls
+	std::stable_sort(sorted.begin(), sorted.end(), intrinsic_less());
+	return sorted;
+}();
+
 unsigned int reshadefx::type::rank(const type &src, const type &dst)
 {
 	if (src.is_array() != dst.is_array() || (src.array_length != dst.array_length && src.is_bounded_array() && dst.is_bounded_array()))
@@ -183,9 +213,24 @@ unsigned int reshadefx::type::rank(const type &src, const type &dst)
 
 reshadefx::symbol_table::symbol_table()
 {
-	_current_scope.name = "::";
 	_current_scope.level = 0;
 	_current_scope.namespace_level = 0;
+	_current_scope.namespace_id = 0;
+
+	_namespace_stack.emplace_back(0, 2);
+	_namespace_names.push_back("::");
+	_namespace_ids.emplace("::", 0);
+}
+
+uint32_t reshadefx::symbol_table::intern_symbol_name(const std::string &name)
+{
+	if (const auto it = _symbol_ids.find(name); it != _symbol_ids.end())
+		return it->second;
+
+	const uint32_t symbol_id = static_cast<uint32_t>(_symbol_stacks.size());
+	_symbol_stacks.emplace_back();
+	_symbol_ids.emplace(name, symbol_id);
+	return symbol_id;
 }
 
 void reshadefx::symbol_table::enter_scope()
@@ -194,28 +239,47 @@ void reshadefx::symbol_table::enter_scope()
 }
 void reshadefx::symbol_table::enter_namespace(const std::string &name)
 {
-	_current_scope.name += name + "::";
+	std::string namespace_name = _namespace_names[_current_scope.namespace_id];
+	namespace_name += name;
+	namespace_name += "::";
+
+	uint32_t namespace_id;
+	if (const auto it = _namespace_ids.find(namespace_name); it != _namespace_ids.end())
+	{
+		namespace_id = it->second;
+	}
+	else
+	{
+		namespace_id = static_cast<uint32_t>(_namespace_names.size());
+		_namespace_ids.emplace(namespace_name, namespace_id);
+		_namespace_names.push_back(namespace_name);
+	}
+
+	_namespace_stack.emplace_back(namespace_id, namespace_name.size());
+
 	_current_scope.level++;
 	_current_scope.namespace_level++;
+	_current_scope.namespace_id = namespace_id;
 }
 void reshadefx::symbol_table::leave_scope()
 {
 	assert(_current_scope.level > 0);
 
-	for (auto &symbol : _symbol_stack)
+	// Only local symbols are recorded in the log, so it is sufficient to remove those that were declared at this level or deeper
+	while (!_scope_undo_log.empty() && _scope_undo_log.back().second >= _current_scope.level)
 	{
-		std::vector<scoped_symbol> &scope_list = symbol.second;
+		std::vector<scoped_symbol> &scope_list = _symbol_stacks[_scope_undo_log.back().first];
+		_scope_undo_log.pop_back();
 
-		for (auto scope_it = scope_list.begin(); scope_it != scope_list.end();)
+		for (auto scope_it = scope_list.end(); scope_it != scope_list.begin();)
 		{
+			--scope_it;
+
 			if (scope_it->scope.level > scope_it->scope.namespace_level &&
 				scope_it->scope.level >= _current_scope.level)
 			{
-				scope_it = scope_list.erase(scope_it);
-			}
-			else
-			{
-				++scope_it;
+				scope_list.erase(scope_it);
+				break;
 			}
 		}
 	}
@@ -227,9 +291,11 @@ void reshadefx::symbol_table::leave_namespace()
 	assert(_current_scope.level > 0);
 	assert(_current_scope.namespace_level > 0);
 
-	_current_scope.name.erase(_current_scope.name.substr(0, _current_scope.name.size() - 2).rfind("::") + 2);
+	_namespace_stack.pop_back();
+
 	_current_scope.level--;
 	_current_scope.namespace_level--;
+	_current_scope.namespace_id = _namespace_stack.back().first;
 }
 
 bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbol &symbol, bool global)
@@ -244,7 +310,7 @@ bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbo
 	const auto insert_sorted = [](auto &vec, const auto &item) {
 		return vec.insert(
 			std::upper_bound(vec.begin(), vec.end(), item,
-				[](auto lhs, auto rhs) {
+				[](const auto &lhs, const auto &rhs) {
 					return lhs.scope.namespace_level < rhs.scope.namespace_level;
 				}), item);
 	};
@@ -252,26 +318,38 @@ bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbo
 	// Global symbols are accessible from every scope
 	if (global)
 	{
-		scope scope = { "", 0, 0 };
+		const std::string &current_name = _namespace_names[_current_scope.namespace_id];
 
-		// Walk scope chain from global scope back to current one
-		for (size_t pos = 0; pos != std::string::npos; pos = _current_scope.name.find("::", pos))
+		// Walk scope chain from global scope back to current one and insert symbol into each of them, qualified with the remaining namespace names
+		std::string qualified_name;
+		for (uint32_t namespace_level = 0; namespace_level <= _current_scope.namespace_level; ++namespace_level)
 		{
-			// Extract scope name
-			scope.name = _current_scope.name.substr(0, pos += 2);
-			const std::string previous_scope_name = _current_scope.name.substr(pos);
+			const scope scope = { namespace_level, namespace_level, _namespace_stack[namespace_level].first };
 
-			// Insert symbol into this scope
-			insert_sorted(_symbol_stack[previous_scope_name + name], scoped_symbol { symbol, scope });
+			uint32_t symbol_id;
+			if (namespace_level == _current_scope.namespace_level)
+			{
+				symbol_id = intern_symbol_name(name);
+			}
+			else
+			{
+				qualified_name.assign(current_name, _namespace_stack[namespace_level].second, std::string::npos);
+				qualified_name += name;
+				symbol_id = intern_symbol_name(qualified_name);
+			}
 
-			// Continue walking up the scope chain
-			scope.level = ++scope.namespace_level;
+			insert_sorted(_symbol_stacks[symbol_id], scoped_symbol { symbol, scope });
 		}
 	}
 	else
 	{
 		// This is a local symbol so it's sufficient to update the symbol stack with just the current scope
-		insert_sorted(_symbol_stack[name], scoped_symbol { symbol, _current_scope });
+		const uint32_t symbol_id = intern_symbol_name(name);
+
+		insert_sorted(_symbol_stacks[symbol_id], scoped_symbol { symbol, _current_scope });
+
+		if (_current_scope.level > _current_scope.namespace_level)
+			_scope_undo_log.emplace_back(symbol_id, _current_scope.level);
 	}
 
 	return true;
@@ -284,19 +362,21 @@ reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string
 }
 reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string &name, const scope &scope, bool exclusive) const
 {
-	const auto stack_it = _symbol_stack.find(name);
+	const auto id_it = _symbol_ids.find(name);
 
 	// Check if symbol does exist
-	if (stack_it == _symbol_stack.end() || stack_it->second.empty())
+	if (id_it == _symbol_ids.end() || _symbol_stacks[id_it->second].empty())
 		return {};
 
+	const std::vector<scoped_symbol> &scope_list = _symbol_stacks[id_it->second];
+
 	// Walk up the scope chain starting at the requested scope level and find a matching symbol
 	scoped_symbol result = {};
 
-	for (auto it = stack_it->second.rbegin(), end = stack_it->second.rend(); it != end; ++it)
+	for (auto it = scope_list.rbegin(), end = scope_list.rend(); it != end; ++it)
 	{
 		if (it->scope.level > scope.level ||
-			it->scope.namespace_level > scope.namespace_level || (it->scope.namespace_level == scope.namespace_level && it->scope.name != scope.name))
+			it->scope.namespace_level > scope.namespace_level || (it->scope.namespace_level == scope.namespace_level && it->scope.namespace_id != scope.namespace_id))
 			continue;
 		if (exclusive && it->scope.level < scope.level)
 			continue;
@@ -368,16 +448,18 @@ bool reshadefx::symbol_table::resolve_function_call(const std::string &name, con
 	unsigned int overload_namespace = scope.namespace_level;
 
 	// Look up function name in the symbol stack and loop through the associated symbols
-	const auto stack_it = _symbol_stack.find(name);
+	const auto id_it = _symbol_ids.find(name);
 
-	if (stack_it != _symbol_stack.end() && !stack_it->second.empty())
+	if (id_it != _symbol_ids.end() && !_symbol_stacks[id_it->second].empty())
 	{
-		for (auto it = stack_it->second.rbegin(), end = stack_it->second.rend(); it != end; ++it)
+		const std::vector<scoped_symbol> &scope_list = _symbol_stacks[id_it->second];
+
+		for (auto it = scope_list.rbegin(), end = scope_list.rend(); it != end; ++it)
 		{
 			if (it->op != symbol_type::function)
 				continue;
 			if (it->scope.level > scope.level ||
-				it->scope.namespace_level > scope.namespace_level || (it->scope.namespace_level == scope.namespace_level && it->scope.name != scope.name))
+				it->scope.namespace_level > scope.namespace_level || (it->scope.namespace_level == scope.namespace_level && it->scope.namespace_id != scope.namespace_id))
 				continue;
 
 			const function *const function = it->function;
@@ -426,10 +508,11 @@ bool reshadefx::symbol_table::resolve_function_call(const std::string &name, con
 	// Try matching against intrinsic functions if no matching user-defined function was found up to this point
 	if (num_overloads == 0)
 	{
-		for (const intrinsic &intrinsic : s_intrinsics)
+		const auto [first, last] = std::equal_range(s_intrinsics_sorted.begin(), s_intrinsics_sorted.end(), std::make_pair(std::string_view(name), arguments.size()), intrinsic_less());
+
+		for (auto it = first; it != last; ++it)
 		{
-			if (intrinsic.name != name || intrinsic.parameter_list.size() != arguments.size())
-				continue;
+			const intrinsic &intrinsic = **it;
 
 			// A new possibly-matching intrinsic function was found, compare it against the current result
 			const int comparison = compare_functions(arguments, &intrinsic, result);
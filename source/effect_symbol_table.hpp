@@ -15,8 +15,11 @@ namespace reshadefx
 	/// </summary>
 	struct scope
 	{
-		std::string name;
 		uint32_t level, namespace_level;
+		/// <summary>
+		/// Interned identifier of the fully qualified name of the namespace this scope is in (zero being the global namespace).
+		/// </summary>
+		uint32_t namespace_id;
 	};
 
 	/// <summary>
@@ -77,6 +80,10 @@ namespace reshadefx
 		/// Gets the current scope the symbol table operates in.
 		/// </summary>
 		const scope &current_scope() const { return _current_scope; }
+		/// <summary>
+		/// Gets the fully qualified name of the namespace the symbol table operates in (e.g. "::" or "::ns::").
+		/// </summary>
+		const std::string &current_scope_name() const { return _namespace_names[_current_scope.namespace_id]; }
 
 		/// <summary>
 		/// Inserts an new symbol in the symbol table.
@@ -96,8 +103,17 @@ namespace reshadefx
 		bool resolve_function_call(const std::string &name, const std::vector<expression> &args, const scope &scope, symbol &data, bool &ambiguous) const;
 
 	private:
+		uint32_t intern_symbol_name(const std::string &name);
+
 		scope _current_scope;
-		// Lookup table from name to matching symbols
-		std::unordered_map<std::string, std::vector<scoped_symbol>> _symbol_stack;
+		// Stack of namespaces entered up to the current scope, with their interned identifier and the length of their fully qualified name
+		std::vector<std::pair<uint32_t, size_t>> _namespace_stack;
+		std::vector<std::string> _namespace_names;
+		std::unordered_map<std::string, uint32_t> _namespace_ids;
+		// Lookup table from name to an interned identifier, which indexes the list of matching symbols (sorted by namespace level)
+		std::unordered_map<std::string, uint32_t> _symbol_ids;
+		std::vector<std::vector<scoped_symbol>> _symbol_stacks;
+		// Log of local symbols inserted in the currently open scopes, so that leaving a scope only has to touch the symbols declared in it
+		std::vector<std::pair<uint32_t, uint32_t>> _scope_undo_log;
 	};
 }
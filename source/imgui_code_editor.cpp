@@ -790,6 +790,8 @@ void reshade::imgui::code_editor::select_all()
 
 void reshade::imgui::code_editor::set_text(const std::string_view text)
 {
+	_text_version++;
+
 	_lines.clear();
 	_lines.emplace_back();
 
@@ -838,6 +840,8 @@ void reshade::imgui::code_editor::append_text(const std::string_view text)
 }
 void reshade::imgui::code_editor::insert_text(const std::string_view text)
 {
+	_text_version++;
+
 	undo_record u;
 	if (!_readonly)
 	{
@@ -899,6 +903,8 @@ void reshade::imgui::code_editor::insert_text(const std::string_view text)
 }
 void reshade::imgui::code_editor::insert_character(uint32_t c, bool auto_indent)
 {
+	_text_version++;
+
 	undo_record u;
 
 	if (has_selection())
@@ -1191,6 +1197,8 @@ void reshade::imgui::code_editor::delete_next()
 {
 	assert(!_readonly);
 
+	_text_version++;
+
 	if (has_selection())
 	{
 		delete_selection();
@@ -1242,6 +1250,8 @@ void reshade::imgui::code_editor::delete_previous()
 {
 	assert(!_readonly);
 
+	_text_version++;
+
 	if (has_selection())
 	{
 		delete_selection();
@@ -1299,6 +1309,8 @@ void reshade::imgui::code_editor::delete_selection()
 	if (!has_selection())
 		return;
 
+	_text_version++;
+
 	assert(!_lines.empty());
 
 	undo_record u;
@@ -1346,6 +1358,8 @@ void reshade::imgui::code_editor::delete_selection()
 }
 void reshade::imgui::code_editor::delete_lines(size_t first_line, size_t last_line)
 {
+	_text_version++;
+
 	// Move all error markers after the deleted lines down
 	std::unordered_map<size_t, std::pair<std::string, bool>> errors;
 	errors.reserve(_errors.size());
@@ -1730,6 +1744,8 @@ void reshade::imgui::code_editor::move_lines_up()
 	if (_select_beg.line == 0)
 		return;
 
+	_text_version++;
+
 	for (size_t line = _select_beg.line; line <= _select_end.line; ++line)
 		std::swap(_lines[line], _lines[line - 1]);
 
@@ -1744,6 +1760,8 @@ void reshade::imgui::code_editor::move_lines_down()
 	if (_select_end.line + 1 >= _lines.size())
 		return;
 
+	_text_version++;
+
 	for (size_t line = _select_end.line; line >= _select_beg.line && line < _lines.size(); --line)
 		std::swap(_lines[line], _lines[line + 1]);
 
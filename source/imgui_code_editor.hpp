@@ -164,6 +164,10 @@ namespace reshade::imgui
 		/// Returns whether the user has modified the text since it was last set via <see cref="set_text"/>.
 		/// </summary>
 		bool is_modified() const { return !_undo.empty() && _undo_index != _undo_base_index; }
+		/// <summary>
+		/// Returns a counter that is incremented every time the text of this text editor changes, which can be used to detect edits without comparing the text.
+		/// </summary>
+		size_t get_text_version() const { return _text_version; }
 
 		/// <summary>
 		/// Adds an error to be displayed at the specified <paramref name="line"/>.
@@ -259,6 +263,7 @@ namespace reshade::imgui
 
 		// Holds the entire text split up into individual character glyphs
 		std::vector<std::vector<glyph>> _lines;
+		size_t _text_version = 0;
 
 		bool _readonly = false;
 		bool _overwrite = false;
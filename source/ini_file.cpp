@@ -8,7 +8,8 @@
 #include <shared_mutex>
 #include <cctype> // std::toupper
 #include <cassert>
-#include <algorithm> // std::min, std::sort, std::transform
+#include <unordered_map>
+#include <algorithm> // std::min, std::sort, std::lexicographical_compare
 #include <utf8/core.h>
 
 static std::shared_mutex s_ini_cache_mutex;
@@ -41,23 +42,46 @@ bool reshade::ini_file::load()
 	_modified = false;
 	_modified_at = modified_at;
 
-	// Remove BOM (0xefbbbf means 0xfeff)
-	if (fgetc(file) != utf8::bom[0] || fgetc(file) != utf8::bom[1] || fgetc(file) != utf8::bom[2])
+	// Read the entire file into a single buffer and parse it in place, to avoid allocating per line
+	std::string file_data;
+	fseek(file, 0, SEEK_END);
+	if (const long file_size = ftell(file); file_size > 0)
+	{
+		file_data.resize(static_cast<size_t>(file_size));
 		fseek(file, 0, SEEK_SET);
+		// Number of bytes read may be less than the file size in text mode, due to line ending conversion
+		file_data.resize(fread(file_data.data(), 1, file_data.size(), file));
+	}
 
-	std::string line_data, section;
-	line_data.resize(BUFSIZ);
-	while (fgets(line_data.data(), static_cast<int>(line_data.size() + 1), file))
-	{
-		size_t line_length;
-		while ((line_length = std::strlen(line_data.data())) == line_data.size() && line_data.back() != '\n')
+	fclose(file);
+
+	std::string_view data = file_data;
+
+	// Remove BOM (0xefbbbf means 0xfeff)
+	if (data.size() >= 3 && static_cast<uint8_t>(data[0]) == utf8::bom[0] && static_cast<uint8_t>(data[1]) == utf8::bom[1] && static_cast<uint8_t>(data[2]) == utf8::bom[2])
+		data.remove_prefix(3);
+
+	section_type *section = &_sections[std::string()];
+	size_t section_offset = 0;
+
+	// Remember the original text of each section, so that saving can write it back unchanged unless the section was modified
+	const auto finish_section = [&data, &section, &section_offset](size_t offset) {
+		if (offset != section_offset)
 		{
-			line_data.resize(line_data.size() + BUFSIZ);
-			if (!fgets(line_data.data() + line_length, static_cast<int>(line_data.size() - line_length + 1), file))
-				break;
+			// Sections that appear multiple times in the file are merged, so have to be serialized again
+			section->modified = !section->data.empty();
+			section->data.assign(data.data() + section_offset, offset - section_offset);
+			if (section->data.back() != '\n')
+				section->data += '\n';
 		}
+	};
+
+	for (size_t line_offset = 0, next_line_offset; line_offset < data.size(); line_offset = next_line_offset)
+	{
+		next_line_offset = data.find('\n', line_offset);
+		next_line_offset = (next_line_offset != std::string_view::npos) ? next_line_offset + 1 : data.size();
 
-		const std::string_view line = trim(std::string_view(line_data.data(), line_length), " \t\r\n");
+		const std::string_view line = trim(data.substr(line_offset, next_line_offset - line_offset), " \t\r\n");
 
 		if (line.empty() || line[0] == ';' || line[0] == '/' || line[0] == '#')
 			continue;
@@ -65,7 +89,10 @@ bool reshade::ini_file::load()
 		// Read section name
 		if (line[0] == '[')
 		{
-			section = trim(line.substr(0, line.find(']')), " \t[]");
+			finish_section(line_offset);
+
+			section = &_sections[std::string(trim(line.substr(0, line.find(']')), " \t[]"))];
+			section_offset = line_offset;
 			continue;
 		}
 
@@ -78,12 +105,12 @@ bool reshade::ini_file::load()
 
 			if (value.empty())
 			{
-				_sections[section].insert({ std::string(key), {} });
+				section->keys.try_emplace(std::string(key));
 				continue;
 			}
 
 			// Append to key if it already exists
-			ini_file::value_type &elements = _sections[section][std::string(key)];
+			ini_file::value_type &elements = section->keys[std::string(key)];
 			for (size_t offset = 0, base = 0, len = value.size(); offset <= len;)
 			{
 				// Treat ",," as an escaped comma and only split on single ","
@@ -97,13 +124,12 @@ bool reshade::ini_file::load()
 					std::string &element = elements.emplace_back();
 					element.reserve(found - base);
 
+					// Copy runs between escaped commas at once, instead of character by character
 					while (base < found)
 					{
-						const char c = value[base++];
-						element += c;
-
-						if (c == ',' && base < found && value[base] == ',')
-							base++; // Skip second comma in a ",," escape sequence
+						const size_t escape = std::min(value.find(",,", base), found);
+						element.append(value.data() + base, std::min(escape + 1, found) - base);
+						base = escape + 2; // Skip second comma in a ",," escape sequence
 					}
 
 					offset = base = found + 1;
@@ -112,14 +138,23 @@ bool reshade::ini_file::load()
 		}
 		else
 		{
-			_sections[section].insert({ std::string(line), {} });
+			section->keys.try_emplace(std::string(line));
 		}
 	}
 
-	fclose(file);
+	finish_section(data.size());
 
 	return true;
 }
+
+static bool compare_case_insensitive(const std::string &a, const std::string &b)
+{
+	return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+		[](std::string::value_type lhs, std::string::value_type rhs) {
+			return std::toupper(static_cast<unsigned char>(lhs)) < std::toupper(static_cast<unsigned char>(rhs));
+		});
+}
+
 bool reshade::ini_file::save()
 {
 	if (!_modified)
@@ -134,74 +169,83 @@ bool reshade::ini_file::save()
 		return false; // File exists and was modified on disk and therefore may have different data, so cannot save
 
 	std::string data;
-	std::vector<std::string> section_names, key_names;
+	std::vector<const std::string *> section_names, key_names;
 
 	section_names.reserve(_sections.size());
 	for (const std::pair<const std::string, section_type> &section : _sections)
-		section_names.push_back(section.first);
+		section_names.push_back(&section.first);
 
 	// Sort sections to generate consistent files
 	std::sort(section_names.begin(), section_names.end(),
-		[](std::string a, std::string b) {
-			std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-			std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-			return a < b;
+		[](const std::string *a, const std::string *b) {
+			return compare_case_insensitive(*a, *b);
 		});
 
-	for (const std::string &section_name : section_names)
+	for (const std::string *const section_name : section_names)
 	{
-		if (const section_type &keys = _sections.at(section_name); !keys.empty())
+		section_type &section = _sections.find(*section_name)->second;
+		if (section.keys.empty())
+			continue;
+
+		// The text of a section that was last in the file may not end in a blank line, so make sure there always is one before the next section
+		if (!data.empty() && (data.size() < 2 || data.compare(data.size() - 2, 2, "\n\n") != 0))
+			data += '\n';
+
+		// Reuse text of sections that were not modified since they were last loaded or saved
+		if (!section.modified)
 		{
-			key_names.clear();
-			key_names.reserve(keys.size());
-			for (const std::pair<const std::string, value_type> &key : keys)
-				key_names.push_back(key.first);
-
-			std::sort(key_names.begin(), key_names.end(),
-				[](std::string a, std::string b) {
-					std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-					std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-					return a < b;
-				});
-
-			// Empty section should have been sorted to the top, so do not need to append it before keys
-			if (!section_name.empty())
-				data += '[' + section_name + ']' + '\n';
-
-			for (const std::string &key_name : key_names)
-			{
-				data += key_name + '=';
+			data += section.data;
+			continue;
+		}
 
-				if (const ini_file::value_type &elements = keys.at(key_name); !elements.empty())
-				{
-					std::string value;
-					for (const std::string &element : elements)
-					{
-						// Empty elements mess with escaped commas, so simply skip them
-						if (element.empty())
-							continue;
-
-						value.reserve(value.size() + element.size() + 1);
-						for (const char c : element)
-							value.append(c == ',' ? 2 : 1, c);
-						value += ','; // Separate multiple values with a comma
-					}
+		const size_t section_offset = data.size();
 
-					// Remove the last comma
-					if (!value.empty())
-					{
-						assert(value.back() == ',');
-						value.pop_back();
-					}
+		key_names.clear();
+		key_names.reserve(section.keys.size());
+		for (const std::pair<const std::string, value_type> &key : section.keys)
+			key_names.push_back(&key.first);
 
-					data += value;
-				}
+		std::sort(key_names.begin(), key_names.end(),
+			[](const std::string *a, const std::string *b) {
+				return compare_case_insensitive(*a, *b);
+			});
 
-				data += '\n';
+		// Empty section should have been sorted to the top, so do not need to append it before keys
+		if (!section_name->empty())
+			data += '[' + *section_name + ']' + '\n';
+
+		for (const std::string *const key_name : key_names)
+		{
+			data += *key_name;
+			data += '=';
+
+			const size_t value_offset = data.size();
+
+			for (const std::string &element : section.keys.at(*key_name))
+			{
+				// Empty elements mess with escaped commas, so simply skip them
+				if (element.empty())
+					continue;
+
+				for (const char c : element)
+					data.append(c == ',' ? 2 : 1, c);
+				data += ','; // Separate multiple values with a comma
+			}
+
+			// Remove the last comma
+			if (data.size() != value_offset)
+			{
+				assert(data.back() == ',');
+				data.pop_back();
 			}
 
 			data += '\n';
 		}
+
+		data += '\n';
+
+		section.data.assign(data, section_offset);
+		section.modified = false;
 	}
 
 	FILE *const file = _wfsopen(_path.c_str(), L"w", SH_DENYWR);
@@ -5,9 +5,10 @@
 
 #pragma once
 
+#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <filesystem>
 
 extern std::filesystem::path g_reshade_dll_path;
@@ -39,13 +40,13 @@ namespace reshade
 		/// <summary>
 		/// Checks whether the specified <paramref name="section"/> and <paramref name="key"/> currently exist in the INI.
 		/// </summary>
-		bool has(const std::string &section, const std::string &key) const
+		bool has(std::string_view section, std::string_view key) const
 		{
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
-			const auto it2 = it1->second.find(key);
-			if (it2 == it1->second.end())
+			const auto it2 = it1->second.keys.find(key);
+			if (it2 == it1->second.keys.end())
 				return false;
 			return true;
 		}
@@ -56,38 +57,38 @@ namespace reshade
 		/// <param name="value">Reference filled with the data of this INI entry.</param>
 		/// <returns><see langword="true"/> if the key exists, <see langword="false"/> otherwise.</returns>
 		template <typename T>
-		bool get(const std::string &section, const std::string &key, T &value) const
+		bool get(std::string_view section, std::string_view key, T &value) const
 		{
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
-			const auto it2 = it1->second.find(key);
-			if (it2 == it1->second.end())
+			const auto it2 = it1->second.keys.find(key);
+			if (it2 == it1->second.keys.end())
 				return false;
 			value = convert<T>(it2->second, 0);
 			return true;
 		}
 		template <typename T, size_t SIZE>
-		bool get(const std::string &section, const std::string &key, T(&values)[SIZE]) const
+		bool get(std::string_view section, std::string_view key, T(&values)[SIZE]) const
 		{
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
-			const auto it2 = it1->second.find(key);
-			if (it2 == it1->second.end())
+			const auto it2 = it1->second.keys.find(key);
+			if (it2 == it1->second.keys.end())
 				return false;
 			for (size_t i = 0; i < SIZE; ++i)
 				values[i] = convert<T>(it2->second, i);
 			return true;
 		}
 		template <typename T>
-		bool get(const std::string &section, const std::string &key, std::vector<T> &values) const
+		bool get(std::string_view section, std::string_view key, std::vector<T> &values) const
 		{
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return false;
-			const auto it2 = it1->second.find(key);
-			if (it2 == it1->second.end())
+			const auto it2 = it1->second.keys.find(key);
+			if (it2 == it1->second.keys.end())
 				return false;
 			if constexpr (std::is_same_v<T, std::string>)
 			{
@@ -119,7 +120,7 @@ namespace reshade
 		/// Returns <see langword="true"/> only if the specified <paramref name="section"/> and <paramref name="key"/> exists and is not zero.
 		/// </summary>
 		/// <returns><see langword="true"/> if the key exists and is not zero, <see langword="false"/> otherwise.</returns>
-		bool get(const std::string &section, const std::string &key) const
+		bool get(std::string_view section, std::string_view key) const
 		{
 			bool value = false;
 			return get<bool>(section, key, value) && value;
@@ -130,9 +131,9 @@ namespace reshade
 		/// </summary>
 		/// <param name="value">Data to set this INI entry to.</param>
 		template <typename T>
-		void set(const std::string &section, const std::string &key, const T &value)
+		void set(std::string_view section, std::string_view key, const T &value)
 		{
-			auto &v = _sections[section][key];
+			auto &v = modify(section, key);
 			if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, const char *>)
 			{
 				v.assign(1, value);
@@ -149,23 +150,19 @@ namespace reshade
 			{
 				v.assign(1, std::to_string(value));
 			}
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
 		}
 		template <typename T, size_t SIZE>
-		void set(const std::string &section, const std::string &key, const T(&values)[SIZE], const size_t size = SIZE)
+		void set(std::string_view section, std::string_view key, const T(&values)[SIZE], const size_t size = SIZE)
 		{
-			auto &v = _sections[section][key];
+			auto &v = modify(section, key);
 			v.resize(size);
 			for (size_t i = 0; i < size; ++i)
 				v[i] = std::to_string(values[i]);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
 		}
 		template <typename T>
-		void set(const std::string &section, const std::string &key, const std::vector<T> &values)
+		void set(std::string_view section, std::string_view key, const std::vector<T> &values)
 		{
-			auto &v = _sections[section][key];
+			auto &v = modify(section, key);
 			if constexpr (std::is_same_v<T, std::string>)
 			{
 				v = values;
@@ -199,24 +196,18 @@ namespace reshade
 				for (size_t i = 0; i < values.size(); ++i)
 					v[i] = std::to_string(values[i]);
 			}
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
 		}
 
-		void set(const std::string &section, const std::string &key, std::string &&value)
+		void set(std::string_view section, std::string_view key, std::string &&value)
 		{
-			auto &v = _sections[section][key];
+			auto &v = modify(section, key);
 			v.resize(1);
 			v[0] = std::forward<std::string>(value);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
 		}
-		void set(const std::string &section, const std::string &key, std::vector<std::string> &&values)
+		void set(std::string_view section, std::string_view key, std::vector<std::string> &&values)
 		{
-			auto &v = _sections[section][key];
+			auto &v = modify(section, key);
 			v = std::forward<std::vector<std::string>>(values);
-			_modified = true;
-			_modified_at = std::filesystem::file_time_type::clock::now();
 		}
 
 		/// <summary>
@@ -232,15 +223,16 @@ namespace reshade
 		/// <summary>
 		/// Removes the specified <paramref name="key"/> from the <paramref name="section"/>.
 		/// </summary>
-		void remove_key(const std::string &section, const std::string &key)
+		void remove_key(std::string_view section, std::string_view key)
 		{
 			const auto it1 = _sections.find(section);
 			if (it1 == _sections.end())
 				return;
-			const auto it2 = it1->second.find(key);
-			if (it2 == it1->second.end())
+			const auto it2 = it1->second.keys.find(key);
+			if (it2 == it1->second.keys.end())
 				return;
-			it1->second.erase(it2);
+			it1->second.keys.erase(it2);
+			it1->second.modified = true;
 			_modified = true;
 			_modified_at = std::filesystem::file_time_type::clock::now();
 		}
@@ -251,6 +243,7 @@ namespace reshade
 		bool load();
 		/// <summary>
 		/// Saves all changes to this INI file to disk.
+		/// Only sections that were modified since the last load or save are serialized again, the text of all others is reused.
 		/// </summary>
 		bool save();
 
@@ -315,10 +308,33 @@ namespace reshade
 		/// <summary>
 		/// Describes a section of multiple key/value pairs in an INI file.
 		/// </summary>
-		using section_type = std::unordered_map<std::string, value_type>;
+		struct section_type
+		{
+			// Ordered map with a transparent comparator, so that keys can be looked up by string view without allocating a string first
+			std::map<std::string, value_type, std::less<>> keys;
+			/// <summary>
+			/// Text of this section as it was last loaded from or saved to disk.
+			/// </summary>
+			std::string data;
+			bool modified = true;
+		};
+
+		value_type &modify(std::string_view section, std::string_view key)
+		{
+			auto it1 = _sections.find(section);
+			if (it1 == _sections.end())
+				it1 = _sections.emplace(section, section_type()).first;
+			auto it2 = it1->second.keys.find(key);
+			if (it2 == it1->second.keys.end())
+				it2 = it1->second.keys.emplace(key, value_type()).first;
+			it1->second.modified = true;
+			_modified = true;
+			_modified_at = std::filesystem::file_time_type::clock::now();
+			return it2->second;
+		}
 
 		const std::filesystem::path _path;
-		std::unordered_map<std::string, section_type> _sections;
+		std::map<std::string, section_type, std::less<>> _sections;
 		bool _modified = false;
 		std::filesystem::file_time_type _modified_at;
 	};
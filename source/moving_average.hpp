@@ -5,17 +5,22 @@
 
 #pragma once
 
+#include <algorithm> // std::min_element, std::max_element, std::nth_element
+
 template <typename T, size_t SAMPLES>
 class moving_average
 {
 public:
-	moving_average() : _index(0), _average(0), _tick_sum(0), _tick_list() {}
+	moving_average() : _index(0), _count(0), _average(0), _tick_sum(0), _tick_list() {}
 
 	operator T() const { return _average; }
 
+	size_t count() const { return _count; }
+
 	void clear()
 	{
 		_index = 0;
+		_count = 0;
 		_average = 0;
 		_tick_sum = 0;
 
@@ -27,10 +32,33 @@ public:
 		_tick_sum -= _tick_list[_index];
 		_tick_sum += _tick_list[_index] = value;
 		_index = ++_index % SAMPLES;
+		_count = std::min(_count + 1, SAMPLES);
 		_average = _tick_sum / SAMPLES;
 	}
 
+	T minimum() const
+	{
+		return _count != 0 ? *std::min_element(_tick_list, _tick_list + _count) : T(0);
+	}
+	T maximum() const
+	{
+		return _count != 0 ? *std::max_element(_tick_list, _tick_list + _count) : T(0);
+	}
+	T percentile(unsigned int percent) const
+	{
+		if (_count == 0)
+			return T(0);
+
+		// Only the first '_count' entries were written to so far (since the list is filled from the start)
+		T sorted_tick_list[SAMPLES];
+		std::copy_n(_tick_list, _count, sorted_tick_list);
+
+		const size_t n = std::min(static_cast<size_t>(percent) * _count / 100, _count - 1);
+		std::nth_element(sorted_tick_list, sorted_tick_list + n, sorted_tick_list + _count);
+		return sorted_tick_list[n];
+	}
+
 private:
-	size_t _index;
+	size_t _index, _count;
 	T _average, _tick_sum, _tick_list[SAMPLES];
 };
@@ -5,6 +5,7 @@
 
 #include "runtime.hpp"
 #include "runtime_internal.hpp"
+#include "effect_lexer.hpp"
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
@@ -16,14 +17,16 @@
 #include "input.hpp"
 #include "platform_utils.hpp"
 #include "reshade_api_object_impl.hpp"
+#include "vulkan/vulkan_impl_device.hpp"
 #include <set>
 #include <cmath> // std::abs, std::fmod
 #include <cctype> // std::toupper
 #include <cwctype> // std::towlower
 #include <cstdio> // std::snprintf
 #include <cstdlib> // std::malloc, std::rand, std::strtod, std::strtol
-#include <cstring> // std::memcpy, std::memset, std::strlen
-#include <algorithm> // std::all_of, std::copy_n, std::equal, std::fill_n, std::find, std::find_if, std::for_each, std::max, std::min, std::replace, std::remove, std::remove_if, std::reverse, std::search, std::set_symmetric_difference, std::sort, std::stable_sort, std::swap, std::transform
+#include <cstring> // std::memcmp, std::memcpy, std::memset, std::strlen
+#include <algorithm> // std::all_of, std::copy_n, std::equal, std::fill_n, std::find, std::find_if, std::for_each, std::max, std::min, std::min_element, std::replace, std::remove, std::remove_if, std::reverse, std::search, std::set_symmetric_difference, std::sort, std::stable_sort, std::swap, std::transform
+#include <utility> // std::exchange
 #include <emmintrin.h>
 #include <smmintrin.h>
 #include <immintrin.h>
@@ -340,9 +343,9 @@ reshade::runtime::runtime(api::swapchain *swapchain, api::command_queue *graphic
 	// Default shortcut PrtScrn
 	_screenshot_key_data[0] = 0x2C;
 
-#if RESHADE_GUI
 	_timestamp_frequency = graphics_queue->get_timestamp_frequency();
 
+#if RESHADE_GUI
 	init_gui();
 #endif
 
@@ -356,9 +359,20 @@ reshade::runtime::runtime(api::swapchain *swapchain, api::command_queue *graphic
 }
 reshade::runtime::~runtime()
 {
-	assert(_worker_threads.empty());
+	assert(_worker_threads.empty() && !_pipeline_cache_save_thread.joinable());
 	assert(!_is_initialized && _techniques.empty() && _technique_sorting.empty());
 
+	if (_statistics_trace_file != nullptr)
+	{
+		fputs("{}]\n", _statistics_trace_file); // Close the JSON array (the empty object is there to deal with the trailing comma of the last event)
+		fclose(_statistics_trace_file);
+	}
+
+#if RESHADE_ADDON
+	if (_statistics_enabled)
+		addon_statistics_enabled.fetch_sub(1, std::memory_order_relaxed);
+#endif
+
 #if RESHADE_GUI
 	// Save configuration before shutting down to ensure the current window state is written to disk
 	save_config();
@@ -570,6 +584,11 @@ bool reshade::runtime::on_init()
 	// Reset frame count to zero so effects are loaded in 'update_effects'
 	_frame_count = 0;
 
+	// Not all APIs support fences, in which case the number of frames in flight cannot be checked and is assumed instead
+	if (!_device->create_fence(0, api::fence_flags::none, &_frame_fence))
+		_frame_fence = {};
+	_frame_fence_pending_value = 0;
+
 	_is_initialized = true;
 	_last_reload_time = std::chrono::high_resolution_clock::now(); // Intentionally set to current time, so that duration to last reload is valid even when there is no reload on init
 
@@ -640,6 +659,14 @@ void reshade::runtime::on_reset()
 	// Already performs a wait for idle, so no need to do it again before destroying resources below
 	destroy_effects();
 
+	destroy_timestamp_queries();
+	_timestamp_frame_index = 0;
+	_timestamp_latency = 0;
+
+	_device->destroy_fence(_frame_fence);
+	_frame_fence = {};
+	_frame_fence_pending_value = 0;
+
 	_device->destroy_resource(_empty_tex);
 	_empty_tex = {};
 	_device->destroy_resource_view(_empty_srv);
@@ -702,6 +729,23 @@ void reshade::runtime::on_present()
 	_is_in_present_call = true;
 #endif
 
+	// The work of the previous frame was submitted along with the previous present, so signal the frame fence for it only now, before anything new is recorded
+	// This avoids having to flush the immediate command list in the middle of a frame (but still costs a queue submit for the signal on some APIs)
+	if (_frame_fence_pending_value != 0 && _frame_fence_pending_value <= _frame_count)
+	{
+		if (!_graphics_queue->signal(_frame_fence, _frame_fence_pending_value))
+		{
+			// Waiting on a value that is never signaled would hang, so stop using the fence altogether
+			log::message(log::level::warning, "Failed to signal frame fence, no longer tracking frames in flight.");
+
+			_graphics_queue->wait_idle();
+			_device->destroy_fence(_frame_fence);
+			_frame_fence = {};
+		}
+
+		_frame_fence_pending_value = 0;
+	}
+
 	api::command_list *const cmd_list = _graphics_queue->get_immediate_command_list();
 
 	capture_state(cmd_list, _app_state);
@@ -738,7 +782,11 @@ void reshade::runtime::on_present()
 	if (_should_save_screenshot && _screenshot_save_before && _effects_enabled && !_effects_rendered_this_frame)
 		save_screenshot("Before");
 
-	if (!is_loading() && !_techniques.empty())
+	if (!is_loading())
+		read_timestamp_queries();
+
+	// Retired effects keep rendering while new ones are loading (see 'render_effects')
+	if (is_loading() ? !_retired_techniques.empty() : !_techniques.empty())
 	{
 		if (_back_buffer_resolved != 0)
 		{
@@ -755,10 +803,15 @@ void reshade::runtime::on_present()
 	if (_should_save_screenshot)
 		save_screenshot(_screenshot_save_before ? "After" : nullptr);
 
+	submit_timestamp_queries(cmd_list);
+
 	_frame_count++;
 	const auto current_time = std::chrono::high_resolution_clock::now();
 	_last_frame_duration = current_time - _last_present_time; _last_present_time = current_time;
 
+	if (_statistics_enabled)
+		update_statistics();
+
 #if RESHADE_GUI
 	// Draw overlay
 	if (_is_vr)
@@ -989,6 +1042,264 @@ void reshade::runtime::on_present()
 #endif
 }
 
+static std::string escape_json_string(const std::string_view value)
+{
+	std::string result;
+	result.reserve(value.size());
+	for (const char c : value)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		if (static_cast<unsigned char>(c) < ' ')
+			continue; // Control characters are not allowed in JSON strings, so just drop them
+		result += c;
+	}
+	return result;
+}
+
+void reshade::runtime::set_statistics_state(bool enabled)
+{
+#if RESHADE_ADDON
+	// Other effect runtimes may gather statistics as well, so only stop measuring add-on event callbacks once none does anymore
+	if (enabled != _statistics_enabled)
+	{
+		if (enabled)
+			addon_statistics_enabled.fetch_add(1, std::memory_order_relaxed);
+		else
+			addon_statistics_enabled.fetch_sub(1, std::memory_order_relaxed);
+
+		// Start from the current totals, so that time measured on behalf of other runtimes before is not attributed to the first frame
+		_addon_cpu_duration_totals.clear();
+	}
+#endif
+
+	_statistics_enabled = enabled;
+
+	if (enabled && _statistics_trace_file == nullptr && !_statistics_trace_path.empty())
+	{
+		std::filesystem::path trace_path = g_reshade_base_path / _statistics_trace_path;
+
+		// Write trace in the Chrome trace event format, which can be opened in Chrome (about://tracing), Perfetto or Tracy (via its import tool)
+		_statistics_trace_file = _wfsopen(trace_path.c_str(), L"w", SH_DENYWR);
+		if (_statistics_trace_file == nullptr)
+		{
+			log::message(log::level::error, "Failed to open statistics trace file '%s'!", trace_path.u8string().c_str());
+			_statistics_trace_path.clear(); // Do not try again
+			return;
+		}
+
+		fputs("[\n", _statistics_trace_file);
+		fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n", _statistics_trace_file);
+		fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}},\n", _statistics_trace_file);
+	}
+}
+
+void reshade::runtime::update_statistics()
+{
+#if RESHADE_ADDON
+	// Collect time spent in add-on event callbacks since the last frame
+	std::string addon_counters;
+	for (const addon_info &info : addon_loaded_info)
+	{
+		if (info.handle == nullptr)
+			continue; // Skip disabled add-ons
+
+		// The totals are shared with other effect runtimes, so take the difference to the total seen last frame instead of resetting them
+		const uint64_t total_duration = info.callback_duration->load(std::memory_order_relaxed);
+		const auto [last_total_duration, first_frame] = _addon_cpu_duration_totals.try_emplace(info.name, total_duration);
+		// The total starts over when an add-on is loaded again
+		const uint64_t duration = first_frame ? 0 : total_duration >= last_total_duration->second ? total_duration - last_total_duration->second : total_duration;
+		last_total_duration->second = total_duration;
+
+		_addon_cpu_durations[info.name].append(duration);
+
+		if (_statistics_trace_file != nullptr)
+		{
+			if (!addon_counters.empty())
+				addon_counters += ',';
+			addon_counters += '\"' + escape_json_string(info.name) + "\":" + std::to_string(duration / 1000);
+		}
+	}
+
+	if (_statistics_trace_file != nullptr && !addon_counters.empty())
+	{
+		const uint64_t time = std::chrono::duration_cast<std::chrono::microseconds>(_last_present_time - _start_time).count();
+		fprintf(_statistics_trace_file, "{\"name\":\"Add-on callbacks (us)\",\"ph\":\"C\",\"pid\":0,\"ts\":%llu,\"args\":{%s}},\n", time, addon_counters.c_str());
+	}
+#endif
+
+	if (_statistics_trace_file != nullptr)
+	{
+		const uint64_t frame_start_time = std::chrono::duration_cast<std::chrono::nanoseconds>((_last_present_time - _last_frame_duration) - _start_time).count();
+		write_statistics_trace_event("Frame " + std::to_string(_frame_count), "frame", 0, frame_start_time, std::chrono::duration_cast<std::chrono::nanoseconds>(_last_frame_duration).count());
+	}
+}
+
+void reshade::runtime::write_statistics_trace_event(const std::string &name, const char *category, uint32_t thread_id, uint64_t start_time, uint64_t duration)
+{
+	assert(_statistics_trace_file != nullptr);
+
+	// Trace event times are in microseconds
+	fprintf(_statistics_trace_file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu},\n",
+		escape_json_string(name).c_str(), category, thread_id, start_time / 1000, start_time % 1000, duration / 1000, duration % 1000);
+}
+
+void reshade::runtime::read_timestamp_queries()
+{
+	if (_timestamp_frequency == 0)
+		return;
+
+	if (_gather_gpu_statistics || _statistics_enabled)
+	{
+		uint32_t required_query_count = 0;
+		for (const technique &tech : _techniques)
+			if (tech.enabled)
+				required_query_count += static_cast<uint32_t>((1 + tech.permutations[0].passes.size()) * 2);
+
+		// Grow query heap when it cannot hold the queries of all enabled techniques anymore
+		if (required_query_count > _timestamp_queries_per_frame)
+		{
+			// Query heap may still be in use by frames in flight
+			_graphics_queue->wait_idle();
+
+			// Leave some room to grow, so that enabling another technique does not immediately require a new query heap
+			const uint32_t queries_per_frame = std::max({ required_query_count, _timestamp_queries_per_frame * 2, 64u });
+
+			destroy_timestamp_queries();
+
+			_timestamp_queries_per_frame = queries_per_frame;
+			const uint32_t total_query_count = _timestamp_queries_per_frame * static_cast<uint32_t>(std::size(_timestamp_frames));
+
+			if (!_device->create_query_heap(api::query_type::timestamp, total_query_count, &_timestamp_query_heap))
+			{
+				log::message(log::level::error, "Failed to create query heap for time measurements!");
+				_timestamp_queries_per_frame = 0;
+				return;
+			}
+
+			// Resolve query results into a buffer on the GPU where possible, so that reading them does not have to go through the query heap
+			if (_device->check_capability(api::device_caps::copy_query_heap_results) &&
+				!_device->create_resource(api::resource_desc(total_query_count * sizeof(uint64_t), api::memory_heap::gpu_to_cpu, api::resource_usage::copy_dest), nullptr, api::resource_usage::copy_dest, &_timestamp_readback_buffer))
+				_timestamp_readback_buffer = {};
+		}
+	}
+
+	// Not all APIs support fences, in which case the query heap is polled for results instead
+	const uint64_t completed_fence_value = _frame_fence != 0 ? _device->get_completed_fence_value(_frame_fence) : 0;
+
+	// Evaluate queries of all frames the GPU has finished, starting with the oldest one
+	for (size_t i = 1; i <= std::size(_timestamp_frames); ++i)
+	{
+		const size_t frame_index = (_timestamp_frame_index + i) % std::size(_timestamp_frames);
+		timestamp_frame &frame = _timestamp_frames[frame_index];
+
+		if (frame.fence_value == 0)
+			continue;
+		if (_frame_fence != 0 && frame.fence_value > completed_fence_value)
+			break;
+
+		const uint32_t first_query = static_cast<uint32_t>(frame_index) * _timestamp_queries_per_frame;
+
+		temp_mem<uint64_t> timestamps(frame.query_count);
+		bool available = false;
+		if (void *mapped_data;
+			_timestamp_readback_buffer != 0 && _device->map_buffer_region(_timestamp_readback_buffer, first_query * sizeof(uint64_t), frame.query_count * sizeof(uint64_t), api::map_access::read_only, &mapped_data))
+		{
+			std::memcpy(timestamps.p, mapped_data, frame.query_count * sizeof(uint64_t));
+			_device->unmap_buffer_region(_timestamp_readback_buffer);
+			available = true;
+		}
+		else
+		{
+			available = _device->get_query_heap_results(_timestamp_query_heap, api::query_type::timestamp, first_query, frame.query_count, timestamps.p, sizeof(uint64_t));
+		}
+
+		// Without a fence the query heap is the only indication of whether the GPU is done, so keep waiting for this frame
+		if (!available && _frame_fence == 0)
+			break;
+
+		for (const auto &[technique_index, query_base_index] : frame.techniques)
+		{
+			if (!available || technique_index >= _techniques.size())
+				break;
+
+			technique &tech = _techniques[technique_index];
+			const uint64_t *const tech_timestamps = timestamps.p + (query_base_index - first_query);
+
+			const uint64_t tech_duration = tech_timestamps[1] - tech_timestamps[0];
+			tech.average_gpu_duration.append(tech_duration * 1'000'000'000ull / _timestamp_frequency);
+
+			for (size_t pass_index = 0; pass_index < tech.permutations[0].passes.size(); ++pass_index)
+			{
+				const uint64_t pass_duration = tech_timestamps[2 + pass_index * 2 + 1] - tech_timestamps[2 + pass_index * 2];
+				tech.permutations[0].passes[pass_index].average_gpu_duration.append(pass_duration * 1'000'000'000ull / _timestamp_frequency);
+			}
+
+			if (_statistics_trace_file != nullptr)
+			{
+				// GPU timestamps use a different time base than the CPU, so make them relative to the first one that was written to the trace
+				if (_statistics_trace_gpu_base_time == 0)
+					_statistics_trace_gpu_base_time = tech_timestamps[0];
+
+				const std::string unique_name = tech.name + '@' + _effects[tech.effect_index].source_file.filename().u8string();
+				write_statistics_trace_event(unique_name, "technique", 1, (tech_timestamps[0] - _statistics_trace_gpu_base_time) * 1'000'000'000ull / _timestamp_frequency, tech_duration * 1'000'000'000ull / _timestamp_frequency);
+
+				for (size_t pass_index = 0; pass_index < tech.permutations[0].passes.size(); ++pass_index)
+				{
+					const technique::pass &pass = tech.permutations[0].passes[pass_index];
+
+					write_statistics_trace_event(
+						pass.name.empty() ? "Pass " + std::to_string(pass_index) : pass.name, "pass", 1,
+						(tech_timestamps[2 + pass_index * 2] - _statistics_trace_gpu_base_time) * 1'000'000'000ull / _timestamp_frequency,
+						(tech_timestamps[2 + pass_index * 2 + 1] - tech_timestamps[2 + pass_index * 2]) * 1'000'000'000ull / _timestamp_frequency);
+				}
+			}
+		}
+
+		if (available)
+			_timestamp_latency = _frame_count - frame.frame_count;
+
+		frame.fence_value = 0;
+		frame.query_count = 0;
+		frame.techniques.clear();
+	}
+}
+void reshade::runtime::submit_timestamp_queries(api::command_list *cmd_list)
+{
+	timestamp_frame &frame = _timestamp_frames[_timestamp_frame_index];
+
+	// Nothing to do if no queries were recorded this frame (or the queries of this frame are still in flight)
+	if (frame.query_count == 0 || frame.fence_value != 0)
+		return;
+
+	if (_timestamp_readback_buffer != 0)
+	{
+		const uint32_t first_query = static_cast<uint32_t>(_timestamp_frame_index) * _timestamp_queries_per_frame;
+		cmd_list->copy_query_heap_results(_timestamp_query_heap, api::query_type::timestamp, first_query, frame.query_count, _timestamp_readback_buffer, first_query * sizeof(uint64_t), sizeof(uint64_t));
+	}
+
+	// Queries are recorded in the immediate command list, so the frame fence is signaled only after that was submitted (see 'on_present')
+	frame.frame_count = _frame_count;
+	frame.fence_value = _frame_count + 1;
+
+	_timestamp_frame_index = (_timestamp_frame_index + 1) % std::size(_timestamp_frames);
+}
+void reshade::runtime::destroy_timestamp_queries()
+{
+	_device->destroy_query_heap(_timestamp_query_heap);
+	_timestamp_query_heap = {};
+	_device->destroy_resource(_timestamp_readback_buffer);
+	_timestamp_readback_buffer = {};
+	_timestamp_queries_per_frame = 0;
+
+	for (timestamp_frame &frame : _timestamp_frames)
+	{
+		frame.fence_value = 0;
+		frame.query_count = 0;
+		frame.techniques.clear();
+	}
+}
+
 void reshade::runtime::load_config()
 {
 	const ini_file &config = ini_file::load_cache(_config_path);
@@ -1020,6 +1331,10 @@ void reshade::runtime::load_config()
 	config_get("GENERAL", "PerformanceMode", _performance_mode);
 	config_get("GENERAL", "PreprocessorDefinitions", _global_preprocessor_definitions);
 	config_get("GENERAL", "SkipLoadingDisabledEffects", _effect_load_skipping);
+	config_get("GENERAL", "EffectVariantCacheSize", _effect_variant_cache_size);
+	config_get("GENERAL", "TextureSourceCacheSize", _texture_source_cache_size);
+	config_get("GENERAL", "BackgroundReload", _effect_background_reload);
+	config_get("GENERAL", "EffectCreationBudget", _effect_creation_budget);
 	config_get("GENERAL", "TextureSearchPaths", _texture_search_paths);
 	config_get("GENERAL", "IntermediateCachePath", _effect_cache_path);
 
@@ -1027,6 +1342,11 @@ void reshade::runtime::load_config()
 	config_get("GENERAL", "PresetPath", _current_preset_path);
 	config_get("GENERAL", "PresetTransitionDuration", _preset_transition_duration);
 
+	bool statistics_enabled = false;
+	config_get("GENERAL", "GatherStatistics", statistics_enabled);
+	config_get("GENERAL", "StatisticsTracePath", _statistics_trace_path);
+	set_statistics_state(statistics_enabled);
+
 	// Fall back to temp directory if cache path does not exist
 	std::error_code ec;
 	if (!resolve_path(_effect_cache_path, ec))
@@ -1097,6 +1417,10 @@ void reshade::runtime::save_config() const
 	config.set("GENERAL", "PerformanceMode", _performance_mode);
 	config.set("GENERAL", "PreprocessorDefinitions", _global_preprocessor_definitions);
 	config.set("GENERAL", "SkipLoadingDisabledEffects", _effect_load_skipping);
+	config.set("GENERAL", "EffectVariantCacheSize", _effect_variant_cache_size);
+	config.set("GENERAL", "TextureSourceCacheSize", _texture_source_cache_size);
+	config.set("GENERAL", "BackgroundReload", _effect_background_reload);
+	config.set("GENERAL", "EffectCreationBudget", _effect_creation_budget);
 	config.set("GENERAL", "TextureSearchPaths", _texture_search_paths);
 	config.set("GENERAL", "IntermediateCachePath", _effect_cache_path);
 
@@ -1142,6 +1466,39 @@ void reshade::runtime::save_config() const
 #endif
 }
 
+static void load_spec_constants(std::vector<reshadefx::uniform> &spec_constants, const reshade::ini_file &preset, const std::string &effect_name)
+{
+	for (reshadefx::uniform &spec_constant : spec_constants)
+	{
+		switch (spec_constant.type.base)
+		{
+		case reshadefx::type::t_int:
+			preset.get(effect_name, spec_constant.name, spec_constant.initializer_value.as_int);
+			break;
+		case reshadefx::type::t_bool:
+		case reshadefx::type::t_uint:
+			preset.get(effect_name, spec_constant.name, spec_constant.initializer_value.as_uint);
+			break;
+		case reshadefx::type::t_float:
+			preset.get(effect_name, spec_constant.name, spec_constant.initializer_value.as_float);
+			break;
+		}
+	}
+}
+static size_t hash_spec_constants(const std::vector<reshadefx::uniform> &spec_constants)
+{
+	std::string spec_constant_attributes;
+
+	for (const reshadefx::uniform &spec_constant : spec_constants)
+	{
+		spec_constant_attributes += spec_constant.name;
+		for (uint32_t i = 0; i < spec_constant.size / 4; ++i)
+			spec_constant_attributes += std::to_string(spec_constant.initializer_value.as_uint[i]);
+	}
+
+	return std::hash<std::string>()(spec_constant_attributes);
+}
+
 void reshade::runtime::load_current_preset()
 {
 	_preset_is_incomplete = false;
@@ -1162,27 +1519,79 @@ void reshade::runtime::load_current_preset()
 	// Recompile effects if preprocessor definitions have changed or running in performance mode (in which case all preset values are compile-time constants)
 	if (_reload_remaining_effects != 0 && (!_is_in_preset_transition || _last_preset_switching_time == _last_present_time)) // ... unless this is the 'load_current_preset' call in 'update_effects' or the call every frame during preset transition
 	{
-		if (_performance_mode || preset_preprocessor_definitions != _preset_preprocessor_definitions)
+		const auto find_definitions = [](const std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> &definitions, const std::string &effect_name) {
+			static const std::vector<std::pair<std::string, std::string>> empty;
+			const auto it = definitions.find(effect_name);
+			return it != definitions.end() ? std::cref(it->second) : std::cref(empty);
+		};
+
+		// Only reload those effects that are actually affected by the differences between the old and new preset, rather than all of them
+		const bool global_definitions_changed = find_definitions(preset_preprocessor_definitions, {}).get() != find_definitions(_preset_preprocessor_definitions, {}).get();
+
+		// A switch to a previous preset may still be waiting for its variants, which are compiled with the preprocessor definitions that are replaced below, so wait for those and reload their effects along with any others
+		std::vector<size_t> reload_effect_indices = std::exchange(_precompile_effect_indices, {});
+		if (!reload_effect_indices.empty())
 		{
-			_preset_preprocessor_definitions = std::move(preset_preprocessor_definitions);
-			reload_effects();
-			return; // Preset values are loaded in 'update_effects' during effect loading
+			for (std::thread &thread : _worker_threads)
+				if (thread.joinable())
+					thread.join();
+			_worker_threads.clear();
 		}
 
-		if (std::find_if(technique_list.cbegin(), technique_list.cend(),
-				[this](const std::string_view technique_name) {
-					const size_t at_pos = technique_name.find('@');
-					if (at_pos == std::string::npos)
-						return true;
-					const auto it = std::find_if(_effects.cbegin(), _effects.cend(),
-						[effect_name = std::filesystem::u8path(technique_name.substr(at_pos + 1))](const effect &effect) {
-							return effect_name == effect.source_file.filename();
+		for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+		{
+			const effect &effect = _effects[effect_index];
+			const std::string effect_name = effect.source_file.filename().u8string();
+
+			bool reload_required = global_definitions_changed || find_definitions(preset_preprocessor_definitions, effect_name).get() != find_definitions(_preset_preprocessor_definitions, effect_name).get();
+
+			if (!reload_required && _performance_mode && effect.compiled && !effect.permutations.empty())
+			{
+				// Compare specialization constant values of the new preset against those the effect was compiled with (starting from the default values, since the new preset may not contain all of them)
+				const std::unique_lock<std::mutex> lock(_effect_variant_cache_mutex);
+
+				const auto [variants_begin, variants_end] = _effect_variant_cache.equal_range(effect.source_hash);
+
+				if (const auto it = std::find_if(variants_begin, variants_end,
+						[&effect](const std::pair<const size_t, std::unique_ptr<effect_variant>> &item) {
+							return item.second->source_file == effect.source_file;
 						});
-					return it != _effects.cend() && it->skipped;
-				}) != technique_list.cend())
+					it != variants_end)
+				{
+					std::vector<reshadefx::uniform> spec_constants = it->second->module.spec_constants;
+					load_spec_constants(spec_constants, preset, effect_name);
+
+					reload_required = hash_spec_constants(spec_constants) != hash_spec_constants(effect.permutations[0].module.spec_constants);
+				}
+				else
+				{
+					reload_required = true;
+				}
+			}
+
+			if (!reload_required && effect.skipped)
+			{
+				reload_required = std::find_if(technique_list.cbegin(), technique_list.cend(),
+					[&effect_name](const std::string_view technique_name) {
+						const size_t at_pos = technique_name.find('@');
+						return at_pos == std::string::npos || technique_name.substr(at_pos + 1) == effect_name;
+					}) != technique_list.cend();
+			}
+
+			if (reload_required && std::find(reload_effect_indices.cbegin(), reload_effect_indices.cend(), effect_index) == reload_effect_indices.cend())
+				reload_effect_indices.push_back(effect_index);
+		}
+
+		_preset_preprocessor_definitions = std::move(preset_preprocessor_definitions);
+
+		if (!reload_effect_indices.empty())
 		{
-			reload_effects();
-			return;
+			// Compile the variants for the new preset in the background first while the current effects keep rendering, so that the switch does not have to wait for them (as long as the variant cache can hold them all)
+			if (!is_loading() && reload_effect_indices.size() <= _effect_variant_cache_size)
+				precompile_effect_variants(reload_effect_indices);
+			else
+				reload_effects(reload_effect_indices);
+			return; // Preset values are loaded in 'update_effects' during effect loading
 		}
 	}
 
@@ -1505,7 +1914,84 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 	return true;
 }
 
-bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, size_t permutation_index, bool force_load, bool preprocess_required)
+static void init_effect_preprocessor(reshadefx::preprocessor &pp, const std::vector<std::pair<std::string, std::string>> &macros, const std::vector<std::filesystem::path> &include_paths)
+{
+	for (const std::pair<std::string, std::string> &macro : macros)
+		pp.add_macro_definition(macro.first, macro.second);
+
+	for (const std::filesystem::path &include_path : include_paths)
+		pp.add_include_path(include_path);
+
+	// Add some conversion macros for compatibility with older versions of ReShade
+	pp.append_string(
+		"#define tex2Doffset(s, coords, offset) tex2D(s, coords, offset)\n"
+		"#define tex2Dlodoffset(s, coords, offset) tex2Dlod(s, coords, offset)\n"
+		"#define tex2Dgather(s, t, c) tex2Dgather##c(s, t)\n"
+		"#define tex2Dgatheroffset(s, t, o, c) tex2Dgather##c(s, t, o)\n"
+		"#define tex2Dgather0 tex2DgatherR\n"
+		"#define tex2Dgather1 tex2DgatherG\n"
+		"#define tex2Dgather2 tex2DgatherB\n"
+		"#define tex2Dgather3 tex2DgatherA\n");
+}
+
+reshadefx::codegen *reshade::runtime::create_effect_codegen(bool debug_info) const
+{
+	unsigned shader_model;
+	if (_renderer_id == 0x9000)
+		shader_model = 30; // D3D9
+	else if (_renderer_id < 0xa100)
+		shader_model = 40; // D3D10 (including feature level 9)
+	else if (_renderer_id < 0xb000 || _device->get_api() == api::device_api::d3d10)
+		shader_model = 41; // D3D10.1
+	else if (_renderer_id < 0xc000 || _device->get_api() == api::device_api::d3d11)
+		shader_model = 50; // D3D11
+	else
+		shader_model = 51; // D3D12
+
+	if ((_renderer_id & 0xF0000) == 0)
+		return reshadefx::create_codegen_dxbc(shader_model, debug_info, _performance_mode, _performance_mode ? 3 : 1);
+	else if (_renderer_id < 0x20000)
+		return reshadefx::create_codegen_glsl(false, debug_info, _performance_mode, false, true);
+	else // Vulkan uses SPIR-V input
+		return reshadefx::create_codegen_spirv(true, debug_info, _performance_mode, false, false);
+}
+
+static std::string find_transient_technique(const reshadefx::effect_module &module, const std::string &texture_name)
+{
+	// A texture is transient if it is only accessed by a single technique and the first pass accessing it clears it as a render target, so that its contents never carry over between techniques or frames
+	const reshadefx::technique *owner = nullptr;
+
+	for (const reshadefx::technique &tech : module.techniques)
+	{
+		for (const reshadefx::pass &pass : tech.passes)
+		{
+			const bool written = std::find(std::begin(pass.render_target_names), std::end(pass.render_target_names), texture_name) != std::end(pass.render_target_names);
+			const bool read =
+				std::any_of(pass.texture_bindings.cbegin(), pass.texture_bindings.cend(),
+					[&module, &texture_name](const reshadefx::texture_binding &binding) { return module.samplers[binding.index].texture_name == texture_name; }) ||
+				std::any_of(pass.storage_bindings.cbegin(), pass.storage_bindings.cend(),
+					[&module, &texture_name](const reshadefx::storage_binding &binding) { return module.storages[binding.index].texture_name == texture_name; });
+
+			if (!written && !read)
+				continue;
+
+			if (owner == nullptr)
+			{
+				if (read || !pass.clear_render_targets)
+					return std::string();
+				owner = &tech;
+			}
+			else if (owner != &tech)
+			{
+				return std::string();
+			}
+		}
+	}
+
+	return owner != nullptr ? owner->name : std::string();
+}
+
+bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, size_t permutation_index, bool force_load, bool preprocess_required, bool variant_only)
 {
 	const std::chrono::high_resolution_clock::time_point time_load_started = std::chrono::high_resolution_clock::now();
 
@@ -1597,7 +2083,16 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
-	effect &effect = _effects[effect_index];
+	// Variants compiled ahead of a preset switch only end up in the variant cache, so are compiled into a separate effect instead of the one in the effect list (see 'precompile_effect_variants')
+	reshade::effect variant_effect;
+	reshade::effect *effect_ptr = &variant_effect;
+	if (!variant_only)
+	{
+		// The effect list may be swapped with the retired effects on the render thread while loading in the background (see 'render_effects'), so only index it while holding the reload mutex
+		const std::shared_lock<std::shared_mutex> lock(_reload_mutex);
+		effect_ptr = &_effects[effect_index];
+	}
+	effect &effect = *effect_ptr;
 
 	const size_t source_hash = std::hash<std::string>()(attributes);
 	if (permutation_index == 0 && (source_file != effect.source_file || source_hash != effect.source_hash))
@@ -1646,87 +2141,194 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	bool preprocessed = effect.preprocessed && permutation_index == 0;
 	bool compiled = effect.compiled && permutation_index == 0;
 	bool source_cached = false;
+	bool variant_cached = false;
 	std::string source;
 	std::string errors;
 
-	if (!preprocessed && (preprocess_required || (source_cached = load_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source)) == false))
+	// Reuse a variant of this effect that was compiled before with the same preprocessor definitions (e.g. when switching back and forth between presets), instead of compiling it again
+	if (permutation_index == 0 && !preprocessed && !compiled && !preprocess_required)
 	{
-		reshadefx::preprocessor pp;
-		pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
-		pp.add_macro_definition("__RESHADE_PERMUTATION__", permutation_index != 0 ? "1" : "0");
-		pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0");
-		pp.add_macro_definition("__VENDOR__", std::to_string(_vendor_id));
-		pp.add_macro_definition("__DEVICE__", std::to_string(_device_id));
-		pp.add_macro_definition("__RENDERER__", std::to_string(_renderer_id));
-		pp.add_macro_definition("__APPLICATION__", std::to_string( // Truncate hash to 32-bit, since lexer currently only supports 32-bit numbers anyway
-			std::hash<std::string>()(g_target_executable_path.stem().u8string()) & 0xFFFFFFFF));
-		pp.add_macro_definition("BUFFER_WIDTH", std::to_string(_effect_permutations[permutation_index].width));
-		pp.add_macro_definition("BUFFER_HEIGHT", std::to_string(_effect_permutations[permutation_index].height));
-		pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
-		pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
-		pp.add_macro_definition("BUFFER_COLOR_SPACE", std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_space)));
-		pp.add_macro_definition("BUFFER_COLOR_FORMAT", std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_format)));
-		pp.add_macro_definition("BUFFER_COLOR_BIT_DEPTH", std::to_string(api::format_bit_depth(_effect_permutations[permutation_index].color_format)));
-
-		for (const std::pair<std::string, std::string> &definition : preprocessor_definitions)
-		{
-			if (definition.first.empty())
-				continue; // Skip invalid definitions
-
-			pp.add_macro_definition(definition.first, definition.second.empty() ? "1" : definition.second);
-		}
-		preprocessor_definitions.clear(); // Clear before reusing for used preprocessor definitions below
-
-		for (const std::filesystem::path &include_path : include_paths)
-			pp.add_include_path(include_path);
+		const std::unique_lock<std::mutex> lock(_effect_variant_cache_mutex);
 
-		// Add some conversion macros for compatibility with older versions of ReShade
-		pp.append_string(
-			"#define tex2Doffset(s, coords, offset) tex2D(s, coords, offset)\n"
-			"#define tex2Dlodoffset(s, coords, offset) tex2Dlod(s, coords, offset)\n"
-			"#define tex2Dgather(s, t, c) tex2Dgather##c(s, t)\n"
-			"#define tex2Dgatheroffset(s, t, o, c) tex2Dgather##c(s, t, o)\n"
-			"#define tex2Dgather0 tex2DgatherR\n"
-			"#define tex2Dgather1 tex2DgatherG\n"
-			"#define tex2Dgather2 tex2DgatherB\n"
-			"#define tex2Dgather3 tex2DgatherA\n");
-
-		// Load and preprocess the source file
-		preprocessed = pp.append_file(source_file);
+		std::vector<reshadefx::uniform> spec_constants;
 
-		// Append preprocessor errors to the error list
-		errors += pp.errors();
+		const auto [variants_begin, variants_end] = _effect_variant_cache.equal_range(source_hash);
 
-		if (preprocessed)
+		if (const auto it = std::find_if(variants_begin, variants_end,
+				[this, &source_file, &preset, &effect_name, &spec_constants](const std::pair<const size_t, std::unique_ptr<effect_variant>> &item) {
+					const effect_variant &variant = *item.second;
+					if (variant.source_file != source_file)
+						return false;
+					if (!_performance_mode)
+						return true;
+					spec_constants = variant.module.spec_constants;
+					load_spec_constants(spec_constants, preset, effect_name);
+					return hash_spec_constants(spec_constants) == variant.spec_constants_hash;
+				});
+			it != variants_end)
 		{
-			source = pp.output();
+			effect_variant &variant = *it->second;
 
-			// Keep track of used preprocessor definitions (so they can be displayed in the overlay)
-			for (const std::pair<std::string, std::string> &definition : pp.used_macro_definitions())
-			{
-				if (definition.first.size() < 8 ||
-					definition.first[0] == '_' ||
-					definition.first.compare(0, 7, "BUFFER_") == 0 ||
-					definition.first.compare(0, 8, "RESHADE_") == 0 ||
-					definition.first.find("INCLUDE_") != std::string::npos)
-					continue;
+			effect.definitions = variant.definitions;
+			effect.included_files = variant.included_files;
 
-				preprocessor_definitions.emplace_back(definition.first, trim(definition.second));
+			permutation.module = variant.module;
+			if (_performance_mode)
+				permutation.module.spec_constants = std::move(spec_constants);
+			permutation.generated_code = variant.generated_code;
+			permutation.cso = variant.cso;
+			permutation.assembly = variant.assembly;
+			errors = variant.errors;
 
-				// Write used preprocessor definitions to the cached source
-				source = "// " + definition.first + '=' + definition.second + '\n' + source;
-			}
+			effect.preprocessed = preprocessed = true;
+			variant_cached = true;
 
-			source_cached = save_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source);
+			variant.last_used = ++_effect_variant_cache_use_count;
 		}
+	}
 
-		if (permutation_index == 0)
-		{
-			effect.definitions = std::move(preprocessor_definitions);
-			std::sort(effect.definitions.begin(), effect.definitions.end());
+	if (variant_only && variant_cached)
+		return true;
 
-			// Keep track of included files
-			effect.included_files = pp.included_files();
+	// Build preprocessor configuration up front, so that it is available even when the preprocessed source is loaded from the cache (see 'check_effect_source')
+	std::vector<std::pair<std::string, std::string>> macros = {
+		{ "__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION) },
+		{ "__RESHADE_PERMUTATION__", permutation_index != 0 ? "1" : "0" },
+		{ "__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0" },
+		{ "__VENDOR__", std::to_string(_vendor_id) },
+		{ "__DEVICE__", std::to_string(_device_id) },
+		{ "__RENDERER__", std::to_string(_renderer_id) },
+		{ "__APPLICATION__", std::to_string( // Truncate hash to 32-bit, since lexer currently only supports 32-bit numbers anyway
+			std::hash<std::string>()(g_target_executable_path.stem().u8string()) & 0xFFFFFFFF) },
+		{ "BUFFER_WIDTH", std::to_string(_effect_permutations[permutation_index].width) },
+		{ "BUFFER_HEIGHT", std::to_string(_effect_permutations[permutation_index].height) },
+		{ "BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)" },
+		{ "BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)" },
+		{ "BUFFER_COLOR_SPACE", std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_space)) },
+		{ "BUFFER_COLOR_FORMAT", std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_format)) },
+		{ "BUFFER_COLOR_BIT_DEPTH", std::to_string(api::format_bit_depth(_effect_permutations[permutation_index].color_format)) },
+	};
+
+	for (const std::pair<std::string, std::string> &definition : preprocessor_definitions)
+	{
+		if (definition.first.empty())
+			continue; // Skip invalid definitions
+
+		macros.emplace_back(definition.first, definition.second.empty() ? "1" : definition.second);
+	}
+
+	std::vector<std::filesystem::path> include_path_list(include_paths.begin(), include_paths.end());
+
+	if (permutation_index == 0)
+	{
+		effect.preprocessor_macros = macros;
+		effect.include_paths = include_path_list;
+	}
+
+	std::unique_ptr<reshadefx::codegen> codegen;
+
+	if (!preprocessed && (preprocess_required || (source_cached = load_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source)) == false))
+	{
+		preprocessor_definitions.clear(); // Clear before reusing for used preprocessor definitions below
+
+		reshadefx::preprocessor pp;
+		init_effect_preprocessor(pp, macros, include_path_list);
+		// The include cache is reset on the render thread once loading finished, which may happen while variants are still compiled in the background, so do not use it for those
+		pp.set_include_cache(variant_only ? nullptr : _effect_include_cache.get());
+
+		reshadefx::parser parser;
+		reshadefx::source_stream stream;
+
+		// Close the stream and join the parse thread on every path out of here, so that an exception thrown while preprocessing cannot leave a joinable thread behind
+		struct parse_thread_guard
+		{
+			reshadefx::source_stream &stream;
+			std::thread thread;
+
+			~parse_thread_guard() { join(); }
+
+			void join()
+			{
+				if (!thread.joinable())
+					return;
+				stream.close();
+				thread.join();
+			}
+		} parse_thread { stream };
+
+		// Parse the pre-processed source code on another thread while it is still being produced, instead of waiting for the preprocessor to finish first
+		if (!compiled)
+		{
+			codegen.reset(create_effect_codegen(!_no_debug_info));
+
+			// Only keep the complete output around if it is going to be written to the cache below, the parser itself only holds a small window of it
+			pp.set_output_stream(&stream, !_no_effect_cache);
+
+			parse_thread.thread = std::thread([&parser, &stream, &codegen, &compiled]() {
+				compiled = parser.parse(stream, codegen.get());
+			});
+		}
+
+		// Load and preprocess the source file
+		preprocessed = pp.append_file(source_file);
+
+		parse_thread.join();
+
+		// Append preprocessor errors to the error list
+		errors += pp.errors();
+
+		if (codegen != nullptr)
+		{
+			if (preprocessed)
+			{
+				// Append parser errors to the error list
+				errors += parser.errors();
+
+				// Write result to effect module
+				permutation.module = codegen->module();
+			}
+			else
+			{
+				// Discard the result of parsing incomplete output, the same as if parsing had not been attempted
+				codegen.reset();
+				compiled = false;
+			}
+		}
+
+		if (preprocessed)
+		{
+			source = pp.output();
+
+			std::string definitions_header;
+
+			// Keep track of used preprocessor definitions (so they can be displayed in the overlay)
+			for (const std::pair<std::string, std::string> &definition : pp.used_macro_definitions())
+			{
+				if (definition.first.size() < 8 ||
+					definition.first[0] == '_' ||
+					definition.first.compare(0, 7, "BUFFER_") == 0 ||
+					definition.first.compare(0, 8, "RESHADE_") == 0 ||
+					definition.first.find("INCLUDE_") != std::string::npos)
+					continue;
+
+				preprocessor_definitions.emplace_back(definition.first, trim(definition.second));
+
+				// Write used preprocessor definitions to the cached source (in reverse order, same as prepending each one to the source)
+				definitions_header.insert(0, "// " + definition.first + '=' + definition.second + '\n');
+			}
+
+			source.insert(0, definitions_header);
+
+			source_cached = save_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source);
+		}
+
+		if (permutation_index == 0)
+		{
+			effect.definitions = std::move(preprocessor_definitions);
+			std::sort(effect.definitions.begin(), effect.definitions.end());
+
+			// Keep track of included files
+			effect.included_files = pp.included_files();
 			std::sort(effect.included_files.begin(), effect.included_files.end()); // Sort file names alphabetically
 
 			effect.preprocessed = preprocessed;
@@ -1759,28 +2361,81 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
-	std::unique_ptr<reshadefx::codegen> codegen;
 	size_t spec_constants_hash = 0;
-	if (!compiled && !source.empty())
-	{
-		unsigned shader_model;
-		if (_renderer_id == 0x9000)
-			shader_model = 30; // D3D9
-		else if (_renderer_id < 0xa100)
-			shader_model = 40; // D3D10 (including feature level 9)
-		else if (_renderer_id < 0xb000 || _device->get_api() == api::device_api::d3d10)
-			shader_model = 41; // D3D10.1
-		else if (_renderer_id < 0xc000 || _device->get_api() == api::device_api::d3d11)
-			shader_model = 50; // D3D11
-		else
-			shader_model = 51; // D3D12
+	std::vector<reshadefx::uniform> default_spec_constants;
+	bool module_cached = false;
+	const std::string module_cache_id = source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash);
+
+	// Restore the effect module and generated code from a previous compile of the same source, so that parsing and code generation can be skipped entirely
+	if (std::string module_data;
+		!variant_cached && !compiled && codegen == nullptr && !source.empty() && !preprocess_required && load_effect_cache(module_cache_id, "module", module_data))
+	{
+		reshadefx::effect_module module;
+		size_t offset = 0;
+		uint64_t cached_spec_constants_hash = 0;
+
+		uint64_t cached_warnings_size = 0;
+
+		// Module is followed by the debug info flag, the hash of the specialization constant values the code was generated with, the warnings reported during compilation and finally the generated code itself
+		if (reshadefx::deserialize_module(module_data, offset, module) &&
+			module_data.size() - offset >= 1 + sizeof(cached_spec_constants_hash) + sizeof(cached_warnings_size) &&
+			module_data[offset] == (_no_debug_info ? '\0' : '\1'))
+		{
+			std::memcpy(&cached_spec_constants_hash, module_data.data() + offset + 1, sizeof(cached_spec_constants_hash));
+			offset += 1 + sizeof(cached_spec_constants_hash);
+			std::memcpy(&cached_warnings_size, module_data.data() + offset, sizeof(cached_warnings_size));
+			offset += sizeof(cached_warnings_size);
+
+			if (_performance_mode)
+			{
+				default_spec_constants = module.spec_constants;
+
+				load_spec_constants(module.spec_constants, preset, effect_name);
+
+				spec_constants_hash = hash_spec_constants(module.spec_constants);
+			}
+
+			// Generated code has specialization constant values baked in, so it can only be reused if those did not change
+			if (spec_constants_hash == cached_spec_constants_hash && module_data.size() - offset >= cached_warnings_size)
+			{
+				std::unordered_map<std::string, std::string> cso, assembly;
+
+				module_cached = std::all_of(module.entry_points.cbegin(), module.entry_points.cend(),
+					[this, &source_file, source_hash, spec_constants_hash, &cso, &assembly](const std::pair<std::string, reshadefx::shader_type> &entry_point) {
+						if (entry_point.second == reshadefx::shader_type::compute && !_device->check_capability(api::device_caps::compute_shader))
+							return false; // Compile normally so that the error is reported
 
-		if ((_renderer_id & 0xF0000) == 0)
-			codegen.reset(reshadefx::create_codegen_dxbc(shader_model, !_no_debug_info, _performance_mode, _performance_mode ? 3 : 1));
-		else if (_renderer_id < 0x20000)
-			codegen.reset(reshadefx::create_codegen_glsl(false, !_no_debug_info, _performance_mode, false, true));
-		else // Vulkan uses SPIR-V input
-			codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, _performance_mode, false, false));
+						const std::string cache_id = source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash) + '-' + std::to_string(spec_constants_hash) + '-' + entry_point.first;
+
+						return load_effect_cache(cache_id, "cso", cso[entry_point.first]) && load_effect_cache(cache_id, "asm", assembly[entry_point.first]);
+					});
+
+				if (module_cached)
+				{
+					permutation.module = std::move(module);
+					errors += module_data.substr(offset, static_cast<size_t>(cached_warnings_size));
+					permutation.generated_code = module_data.substr(offset + static_cast<size_t>(cached_warnings_size));
+					permutation.cso = std::move(cso);
+					permutation.assembly = std::move(assembly);
+				}
+			}
+
+			if (!module_cached)
+			{
+				spec_constants_hash = 0;
+				default_spec_constants.clear();
+			}
+		}
+	}
+
+	if (variant_cached || module_cached)
+	{
+		// Effect module and shader code were restored from the variant or module cache, so only need to set up the uniform variables again
+		compiled = true;
+	}
+	else if (!compiled && codegen == nullptr && !source.empty())
+	{
+		codegen.reset(create_effect_codegen(!_no_debug_info));
 
 		reshadefx::parser parser;
 
@@ -1792,198 +2447,186 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 
 		// Write result to effect module
 		permutation.module = codegen->module();
+	}
 
-		if (compiled)
+	if (compiled && (variant_cached || module_cached || codegen != nullptr))
+	{
+		if (permutation_index == 0 && !variant_only)
 		{
-			if (permutation_index == 0)
-			{
-				effect.uniforms.clear();
+			// Initial values are written through the effect list (see 'reset_uniform_value'), so have to hold the reload mutex for the same reason as above
+			const std::shared_lock<std::shared_mutex> lock(_reload_mutex);
 
-				// Create space for all variables (aligned to 16 bytes)
-				effect.uniform_data_storage.resize((permutation.module.total_uniform_size + 15) & ~15);
+			effect.uniforms.clear();
 
-				for (uniform variable : permutation.module.uniforms)
-				{
-					variable.effect_index = effect_index;
-
-					const std::string_view special = variable.annotation_as_string("source");
-					if (special.empty()) /* Ignore if annotation is missing */
-						variable.special = special_uniform::none;
-					else if (special == "frametime")
-						variable.special = special_uniform::frame_time;
-					else if (special == "framecount")
-						variable.special = special_uniform::frame_count;
-					else if (special == "random")
-						variable.special = special_uniform::random;
-					else if (special == "pingpong")
-						variable.special = special_uniform::ping_pong;
-					else if (special == "date")
-						variable.special = special_uniform::date;
-					else if (special == "timer")
-						variable.special = special_uniform::timer;
-					else if (special == "key")
-						variable.special = special_uniform::key;
-					else if (special == "mousepoint")
-						variable.special = special_uniform::mouse_point;
-					else if (special == "mousedelta")
-						variable.special = special_uniform::mouse_delta;
-					else if (special == "mousebutton")
-						variable.special = special_uniform::mouse_button;
-					else if (special == "mousewheel")
-						variable.special = special_uniform::mouse_wheel;
-					else if (special == "ui_open" || special == "overlay_open")
-						variable.special = special_uniform::overlay_open;
-					else if (special == "ui_active" || special == "overlay_active")
-						variable.special = special_uniform::overlay_active;
-					else if (special == "ui_hovered" || special == "overlay_hovered")
-						variable.special = special_uniform::overlay_hovered;
-					else if (special == "screenshot")
-						variable.special = special_uniform::screenshot;
-					else
-						variable.special = special_uniform::unknown;
+			// Create space for all variables (aligned to 16 bytes)
+			effect.uniform_data_storage.resize((permutation.module.total_uniform_size + 15) & ~15);
 
-					// Copy initial data into uniform storage area
-					reset_uniform_value(variable);
+			for (uniform variable : permutation.module.uniforms)
+			{
+				variable.effect_index = effect_index;
+
+				const std::string_view special = variable.annotation_as_string("source");
+				if (special.empty()) /* Ignore if annotation is missing */
+					variable.special = special_uniform::none;
+				else if (special == "frametime")
+					variable.special = special_uniform::frame_time;
+				else if (special == "framecount")
+					variable.special = special_uniform::frame_count;
+				else if (special == "random")
+					variable.special = special_uniform::random;
+				else if (special == "pingpong")
+					variable.special = special_uniform::ping_pong;
+				else if (special == "date")
+					variable.special = special_uniform::date;
+				else if (special == "timer")
+					variable.special = special_uniform::timer;
+				else if (special == "key")
+					variable.special = special_uniform::key;
+				else if (special == "mousepoint")
+					variable.special = special_uniform::mouse_point;
+				else if (special == "mousedelta")
+					variable.special = special_uniform::mouse_delta;
+				else if (special == "mousebutton")
+					variable.special = special_uniform::mouse_button;
+				else if (special == "mousewheel")
+					variable.special = special_uniform::mouse_wheel;
+				else if (special == "ui_open" || special == "overlay_open")
+					variable.special = special_uniform::overlay_open;
+				else if (special == "ui_active" || special == "overlay_active")
+					variable.special = special_uniform::overlay_active;
+				else if (special == "ui_hovered" || special == "overlay_hovered")
+					variable.special = special_uniform::overlay_hovered;
+				else if (special == "screenshot")
+					variable.special = special_uniform::screenshot;
+				else
+					variable.special = special_uniform::unknown;
 
-					effect.uniforms.push_back(std::move(variable));
-				}
+				// Copy initial data into uniform storage area
+				reset_uniform_value(variable);
+
+				effect.uniforms.push_back(std::move(variable));
 			}
-			else
+		}
+		else if (permutation_index != 0)
+		{
+			if (permutation.module.total_uniform_size != effect.permutations[0].module.total_uniform_size ||
+				!std::equal(
+					permutation.module.uniforms.begin(), permutation.module.uniforms.end(),
+					effect.permutations[0].module.uniforms.begin(), effect.permutations[0].module.uniforms.end(),
+					[](const reshadefx::uniform &lhs_variable, const reshadefx::uniform &rhs_variable) {
+						return lhs_variable.offset == rhs_variable.offset && lhs_variable.size == rhs_variable.size && lhs_variable.type == rhs_variable.type && lhs_variable.name == rhs_variable.name;
+					}))
 			{
-				if (permutation.module.total_uniform_size != effect.permutations[0].module.total_uniform_size ||
-					!std::equal(
-						permutation.module.uniforms.begin(), permutation.module.uniforms.end(),
-						effect.permutations[0].module.uniforms.begin(), effect.permutations[0].module.uniforms.end(),
-						[](const reshadefx::uniform &lhs_variable, const reshadefx::uniform &rhs_variable) {
-							return lhs_variable.offset == rhs_variable.offset && lhs_variable.size == rhs_variable.size && lhs_variable.type == rhs_variable.type && lhs_variable.name == rhs_variable.name;
-						}))
+				errors += "error: effect permutation defines different uniform variables";
+
+				std::vector<std::string> lhs_uniform_names;
+				lhs_uniform_names.reserve(permutation.module.uniforms.size());
+				std::transform(
+					permutation.module.uniforms.begin(), permutation.module.uniforms.end(),
+					std::back_inserter(lhs_uniform_names),
+					[](const reshadefx::uniform &variable) { return variable.name; });
+				std::sort(lhs_uniform_names.begin(), lhs_uniform_names.end());
+
+				std::vector<std::string> rhs_uniform_names;
+				rhs_uniform_names.reserve(effect.permutations[0].module.uniforms.size());
+				std::transform(
+					effect.permutations[0].module.uniforms.begin(), effect.permutations[0].module.uniforms.end(),
+					std::back_inserter(rhs_uniform_names),
+					[](const reshadefx::uniform &variable) { return variable.name; });
+				std::sort(rhs_uniform_names.begin(), rhs_uniform_names.end());
+
+				std::vector<std::string> different_uniform_names;
+				different_uniform_names.reserve(std::max(lhs_uniform_names.size(), rhs_uniform_names.size()));
+				std::set_symmetric_difference(
+					lhs_uniform_names.begin(), lhs_uniform_names.end(),
+					rhs_uniform_names.begin(), rhs_uniform_names.end(),
+					std::back_inserter(different_uniform_names));
+
+				if (!different_uniform_names.empty())
 				{
-					errors += "error: effect permutation defines different uniform variables";
-
-					std::vector<std::string> lhs_uniform_names;
-					lhs_uniform_names.reserve(permutation.module.uniforms.size());
-					std::transform(
-						permutation.module.uniforms.begin(), permutation.module.uniforms.end(),
-						std::back_inserter(lhs_uniform_names),
-						[](const reshadefx::uniform &variable) { return variable.name; });
-					std::sort(lhs_uniform_names.begin(), lhs_uniform_names.end());
-
-					std::vector<std::string> rhs_uniform_names;
-					rhs_uniform_names.reserve(effect.permutations[0].module.uniforms.size());
-					std::transform(
-						effect.permutations[0].module.uniforms.begin(), effect.permutations[0].module.uniforms.end(),
-						std::back_inserter(rhs_uniform_names),
-						[](const reshadefx::uniform &variable) { return variable.name; });
-					std::sort(rhs_uniform_names.begin(), rhs_uniform_names.end());
-
-					std::vector<std::string> different_uniform_names;
-					different_uniform_names.reserve(std::max(lhs_uniform_names.size(), rhs_uniform_names.size()));
-					std::set_symmetric_difference(
-						lhs_uniform_names.begin(), lhs_uniform_names.end(),
-						rhs_uniform_names.begin(), rhs_uniform_names.end(),
-						std::back_inserter(different_uniform_names));
-
-					if (!different_uniform_names.empty())
-					{
-						errors += " (";
-						errors += different_uniform_names[0];
-						for (size_t i = 1; i < different_uniform_names.size(); ++i)
-							errors += ", " + different_uniform_names[i];
-						errors +=  ')';
-					}
-
-					errors += '\n';
-					compiled = false;
+					errors += " (";
+					errors += different_uniform_names[0];
+					for (size_t i = 1; i < different_uniform_names.size(); ++i)
+						errors += ", " + different_uniform_names[i];
+					errors +=  ')';
 				}
 
-				if (!std::equal(
-						permutation.module.techniques.begin(), permutation.module.techniques.end(),
-						effect.permutations[0].module.techniques.begin(), effect.permutations[0].module.techniques.end(),
-						[](const reshadefx::technique &lhs_tech, const reshadefx::technique &rhs_tech) {
-							return lhs_tech.name == rhs_tech.name;
-						}))
-				{
-					errors += "error: effect permutation defines different techniques";
-
-					std::vector<std::string> lhs_technique_names;
-					lhs_technique_names.reserve(permutation.module.techniques.size());
-					std::transform(
-						permutation.module.techniques.begin(), permutation.module.techniques.end(),
-						std::back_inserter(lhs_technique_names),
-						[](const reshadefx::technique &tech) { return tech.name; });
-					std::sort(lhs_technique_names.begin(), lhs_technique_names.end());
-
-					std::vector<std::string> rhs_technique_names;
-					rhs_technique_names.reserve(effect.permutations[0].module.techniques.size());
-					std::transform(
-						effect.permutations[0].module.techniques.begin(), effect.permutations[0].module.techniques.end(),
-						std::back_inserter(rhs_technique_names),
-						[](const reshadefx::technique &tech) { return tech.name; });
-					std::sort(rhs_technique_names.begin(), rhs_technique_names.end());
-
-					std::vector<std::string> different_technique_names;
-					different_technique_names.reserve(std::max(lhs_technique_names.size(), rhs_technique_names.size()));
-					std::set_symmetric_difference(
-						lhs_technique_names.begin(), lhs_technique_names.end(),
-						rhs_technique_names.begin(), rhs_technique_names.end(),
-						std::back_inserter(different_technique_names));
-
-					if (!different_technique_names.empty())
-					{
-						errors += " (";
-						errors += different_technique_names[0];
-						for (size_t i = 1; i < different_technique_names.size(); ++i)
-							errors += ", " + different_technique_names[i];
-						errors += ')';
-					}
-
-					errors += '\n';
-					compiled = false;
-				}
+				errors += '\n';
+				compiled = false;
 			}
 
-			// Fill all specialization constants with values from the current preset
-			if (_performance_mode)
+			if (!std::equal(
+					permutation.module.techniques.begin(), permutation.module.techniques.end(),
+					effect.permutations[0].module.techniques.begin(), effect.permutations[0].module.techniques.end(),
+					[](const reshadefx::technique &lhs_tech, const reshadefx::technique &rhs_tech) {
+						return lhs_tech.name == rhs_tech.name;
+					}))
 			{
-				std::string spec_constant_attributes;
-
-				for (reshadefx::uniform &spec_constant : permutation.module.spec_constants)
+				errors += "error: effect permutation defines different techniques";
+
+				std::vector<std::string> lhs_technique_names;
+				lhs_technique_names.reserve(permutation.module.techniques.size());
+				std::transform(
+					permutation.module.techniques.begin(), permutation.module.techniques.end(),
+					std::back_inserter(lhs_technique_names),
+					[](const reshadefx::technique &tech) { return tech.name; });
+				std::sort(lhs_technique_names.begin(), lhs_technique_names.end());
+
+				std::vector<std::string> rhs_technique_names;
+				rhs_technique_names.reserve(effect.permutations[0].module.techniques.size());
+				std::transform(
+					effect.permutations[0].module.techniques.begin(), effect.permutations[0].module.techniques.end(),
+					std::back_inserter(rhs_technique_names),
+					[](const reshadefx::technique &tech) { return tech.name; });
+				std::sort(rhs_technique_names.begin(), rhs_technique_names.end());
+
+				std::vector<std::string> different_technique_names;
+				different_technique_names.reserve(std::max(lhs_technique_names.size(), rhs_technique_names.size()));
+				std::set_symmetric_difference(
+					lhs_technique_names.begin(), lhs_technique_names.end(),
+					rhs_technique_names.begin(), rhs_technique_names.end(),
+					std::back_inserter(different_technique_names));
+
+				if (!different_technique_names.empty())
 				{
-					switch (spec_constant.type.base)
-					{
-					case reshadefx::type::t_int:
-						preset.get(effect_name, spec_constant.name, spec_constant.initializer_value.as_int);
-						break;
-					case reshadefx::type::t_bool:
-					case reshadefx::type::t_uint:
-						preset.get(effect_name, spec_constant.name, spec_constant.initializer_value.as_uint);
-						break;
-					case reshadefx::type::t_float:
-						preset.get(effect_name, spec_constant.name, spec_constant.initializer_value.as_float);
-						break;
-					}
-
-					spec_constant_attributes += spec_constant.name;
-					for (uint32_t i = 0; i < spec_constant.size / 4; ++i)
-						spec_constant_attributes += std::to_string(spec_constant.initializer_value.as_uint[i]);
+					errors += " (";
+					errors += different_technique_names[0];
+					for (size_t i = 1; i < different_technique_names.size(); ++i)
+						errors += ", " + different_technique_names[i];
+					errors += ')';
 				}
 
-				spec_constants_hash = std::hash<std::string>()(spec_constant_attributes);
+				errors += '\n';
+				compiled = false;
+			}
+		}
+
+		// Fill all specialization constants with values from the current preset (cached variants and modules already had that done during lookup)
+		if (_performance_mode)
+		{
+			if (!variant_cached && !module_cached)
+			{
+				default_spec_constants = permutation.module.spec_constants;
+
+				load_spec_constants(permutation.module.spec_constants, preset, effect_name);
 
 				// Update specialization constant values for when code is generated below in 'finalize_code' and 'assemble_code_for_entry_point'
 				codegen->module().spec_constants = permutation.module.spec_constants;
 			}
-		}
-		else if (!preprocessed)
-		{
-			assert(!preprocess_required);
 
-			return load_effect(source_file, preset, effect_index, permutation_index, force_load, true);
+			spec_constants_hash = hash_spec_constants(permutation.module.spec_constants);
 		}
+	}
+	else if (codegen != nullptr && !preprocessed)
+	{
+		assert(!preprocess_required);
 
-		permutation.generated_code = codegen->finalize_code();
+		return load_effect(source_file, preset, effect_index, permutation_index, force_load, true, variant_only);
 	}
 
+	if (codegen != nullptr)
+		permutation.generated_code = codegen->finalize_code();
+
 	if ((preprocessed || source_cached) && compiled)
 	{
 		if (permutation.cso.empty())
@@ -2025,6 +2668,99 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 			}
 		}
 
+		// Store the effect module and generated code, so that the next time this effect is loaded it does not have to be parsed again
+		if (compiled && codegen != nullptr)
+		{
+			std::string module_data;
+
+			// Cache the module with specialization constants set to their default values, same as the variant cache below
+			if (_performance_mode)
+				permutation.module.spec_constants.swap(default_spec_constants);
+			reshadefx::serialize_module(permutation.module, module_data);
+			if (_performance_mode)
+				permutation.module.spec_constants.swap(default_spec_constants);
+
+			const uint64_t cached_spec_constants_hash = spec_constants_hash;
+			const uint64_t cached_warnings_size = errors.size();
+			module_data.push_back(_no_debug_info ? '\0' : '\1');
+			module_data.append(reinterpret_cast<const char *>(&cached_spec_constants_hash), sizeof(cached_spec_constants_hash));
+			// Keep warnings, so that they are still reported when the module is restored from the cache
+			module_data.append(reinterpret_cast<const char *>(&cached_warnings_size), sizeof(cached_warnings_size));
+			module_data.append(errors);
+			module_data.append(permutation.generated_code);
+
+			save_effect_cache(module_cache_id, "module", module_data);
+		}
+
+		// Remember the compiled result for this set of preprocessor definitions, so that switching back to it later on does not require compiling again
+		if (compiled && permutation_index == 0 && !variant_cached && _effect_variant_cache_size != 0)
+		{
+			auto variant = std::make_unique<effect_variant>();
+			variant->source_file = source_file;
+			variant->source_hash = source_hash;
+			variant->spec_constants_hash = spec_constants_hash;
+			variant->included_files = effect.included_files;
+			variant->definitions = effect.definitions;
+			variant->module = permutation.module;
+			if (_performance_mode)
+				variant->module.spec_constants = std::move(default_spec_constants);
+			variant->generated_code = permutation.generated_code;
+			variant->cso = permutation.cso;
+			variant->assembly = permutation.assembly;
+			variant->errors = errors;
+
+			const std::unique_lock<std::mutex> lock(_effect_variant_cache_mutex);
+
+			variant->last_used = ++_effect_variant_cache_use_count;
+
+			const auto [variants_begin, variants_end] = _effect_variant_cache.equal_range(source_hash);
+
+			// Only replace a variant compiled with the same specialization constant values, so that presets which only differ in those can coexist in the cache
+			if (const auto it = std::find_if(variants_begin, variants_end,
+					[&source_file, spec_constants_hash](const std::pair<const size_t, std::unique_ptr<effect_variant>> &item) {
+						return item.second->spec_constants_hash == spec_constants_hash && item.second->source_file == source_file;
+					});
+				it != variants_end)
+			{
+				it->second = std::move(variant);
+			}
+			else
+			{
+				// Evict the least recently used variant when the cache is full (this only happens after a compile, so is cheap in comparison)
+				if (_effect_variant_cache.size() >= _effect_variant_cache_size)
+					_effect_variant_cache.erase(std::min_element(_effect_variant_cache.begin(), _effect_variant_cache.end(),
+						[](const std::pair<const size_t, std::unique_ptr<effect_variant>> &lhs, const std::pair<const size_t, std::unique_ptr<effect_variant>> &rhs) {
+							return lhs.second->last_used < rhs.second->last_used;
+						}));
+
+				_effect_variant_cache.emplace(source_hash, std::move(variant));
+			}
+		}
+
+		// Decode image files referenced by textures here already, so that this happens in parallel on the loading threads and 'load_textures' can later just upload the cached result
+		if (compiled && permutation_index == 0 && _texture_source_cache_size != 0)
+		{
+			for (const reshadefx::texture &texture_info : permutation.module.textures)
+			{
+				if (!texture_info.semantic.empty() || std::none_of(texture_info.annotations.cbegin(), texture_info.annotations.cend(),
+						[](const reshadefx::annotation &annotation) { return annotation.name == "source"; }))
+					continue;
+
+				const texture tex(texture_info);
+
+				std::filesystem::path source_path = std::filesystem::u8path(tex.annotation_as_string("source"));
+				if (source_path.empty() || !find_file(_texture_search_paths, source_path))
+					continue;
+
+				// Errors are reported later in 'load_textures'
+				std::string texture_errors;
+				load_texture_source(tex, source_path, texture_errors);
+			}
+		}
+
+		if (variant_only)
+			return true;
+
 		const std::unique_lock<std::shared_mutex> lock(_reload_mutex);
 
 		for (texture new_texture : permutation.module.textures)
@@ -2080,8 +2816,13 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				}
 
 				if (!shared_permutation)
+				{
 					existing_texture->shared.push_back(effect_index);
 
+					// Texture contents may be passed between effects now, so it can no longer alias memory with other textures
+					existing_texture->transient_technique.clear();
+				}
+
 				// Update render target and storage access flags of the existing shared texture, in case they are used as such in this effect
 				existing_texture->render_target |= new_texture.render_target;
 				existing_texture->storage_access |= new_texture.storage_access;
@@ -2132,6 +2873,9 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 			// This is the first effect using this texture
 			new_texture.shared.push_back(effect_index);
 
+			if (new_texture.semantic.empty() && new_texture.annotation_as_string("source").empty())
+				new_texture.transient_technique = find_transient_technique(permutation.module, new_texture.unique_name);
+
 			_textures.push_back(std::move(new_texture));
 		}
 
@@ -2167,6 +2911,10 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
+	// Errors of variants that failed to compile ahead of time are reported when the effect is actually loaded with them
+	if (variant_only)
+		return false;
+
 	effect.compiled = compiled;
 
 	if (!errors.empty())
@@ -2199,6 +2947,54 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		return false;
 	}
 }
+#if RESHADE_GUI
+void reshade::runtime::check_effect_source(const std::filesystem::path &source_file, const std::vector<std::pair<std::string, std::string>> &macros, const std::vector<std::filesystem::path> &include_paths, const std::filesystem::path &edited_file, std::string edited_source, editor_check_result &result) const
+{
+	// Enforce the source to end with a line feed, same as when reading files
+	if (edited_source.empty() || edited_source.back() != '\n')
+		edited_source.push_back('\n');
+
+	reshadefx::preprocessor pp;
+	init_effect_preprocessor(pp, macros, include_paths);
+
+	bool preprocessed = false;
+
+	// Replace the file that is being edited with the current text of the editor, which may either be the effect file itself or one of the files it includes
+	if (edited_file == source_file)
+	{
+		preprocessed = pp.append_string(std::move(edited_source), source_file);
+	}
+	else
+	{
+		pp.override_file(edited_file, std::move(edited_source));
+		preprocessed = pp.append_file(source_file);
+	}
+
+	result.errors = pp.errors();
+
+	// Do not parse incomplete output after preprocessing failed, same as in 'load_effect'
+	if (!preprocessed)
+		return;
+
+	std::string source = pp.output();
+
+	// Edits that do not change the preprocessed output (e.g. in comments or inactive preprocessor blocks) cannot change the parser result either, so only parse again when it did change
+	if (const size_t source_hash = std::hash<std::string>()(source);
+		source_hash != result.source_hash)
+	{
+		const std::unique_ptr<reshadefx::codegen> codegen(create_effect_codegen(false));
+
+		reshadefx::parser parser;
+		parser.parse(std::move(source), codegen.get());
+
+		result.source_hash = source_hash;
+		result.parser_errors = parser.errors();
+	}
+
+	result.errors += result.parser_errors;
+}
+#endif
+
 bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_index)
 {
 	effect &effect = _effects[effect_index];
@@ -2220,7 +3016,9 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 		if (tex.resource != 0)
 		{
 			if (!(tex.render_target && tex.rtv[0] == 0) &&
-				!(tex.storage_access && _renderer_id >= 0xb000 && tex.uav.empty()))
+				!(tex.storage_access && _renderer_id >= 0xb000 && tex.uav.empty()) &&
+				!(tex.transient_technique.empty() && std::any_of(_transient_textures.cbegin(), _transient_textures.cend(),
+					[&tex](const transient_texture_allocation &allocation) { return allocation.resource == tex.resource; })))
 				continue;
 
 			// Update texture if usage has changed since it was last created (e.g. because a pooled texture is now used with storage access when it was not before)
@@ -2247,16 +3045,6 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 		}
 	}
 
-	// Build specialization constants
-	std::vector<uint32_t> spec_data;
-	std::vector<uint32_t> spec_constants;
-	for (const reshadefx::uniform &spec_constant : permutation.module.spec_constants)
-	{
-		uint32_t id = static_cast<uint32_t>(spec_constants.size());
-		spec_data.push_back(spec_constant.initializer_value.as_uint[0]);
-		spec_constants.push_back(id);
-	}
-
 	// Initialize bindings
 	const bool sampler_with_resource_view = _device->check_capability(api::device_caps::sampler_with_resource_view);
 
@@ -2312,13 +3100,6 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 		}
 	}
 
-	// Create optional query heap for time measurements
-	if (permutation_index == 0 &&
-		!_device->create_query_heap(api::query_type::timestamp, static_cast<uint32_t>((permutation.module.techniques.size() + total_pass_count) * 2 * 4), &effect.query_heap))
-	{
-		log::message(log::level::error, "Failed to create query heap for effect file '%s'!", effect.source_file.u8string().c_str());
-	}
-
 	std::vector<api::descriptor_table_update> descriptor_writes;
 	descriptor_writes.reserve(
 		static_cast<size_t>(cb_range.count) +
@@ -2368,13 +3149,30 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 	}
 
 	// Create global constant buffer (except in D3D9, which does not have constant buffers)
-	api::buffer_range cb_buffer_range = {};
+	std::vector<api::buffer_range> cb_buffer_ranges;
 	if (_device->get_api() != api::device_api::d3d9 && !effect.uniform_data_storage.empty())
 	{
 		if (permutation_index == 0)
 		{
+			// Mapping does not rename the buffer in D3D12 and Vulkan, so need multiple slices there to not overwrite data still in use by frames in flight, whereas other APIs do that already when discarding
+			if (_device->get_api() == api::device_api::d3d12 || _device->get_api() == api::device_api::vulkan)
+			{
+				effect.cb_slice_size = (effect.uniform_data_storage.size() + 255) & ~static_cast<size_t>(255); // Constant buffer offsets have to be aligned to 256 bytes
+				effect.cb_slice_count = effect.cb_frames_in_flight * effect.cb_slices_per_frame;
+			}
+			else
+			{
+				effect.cb_slice_size = effect.uniform_data_storage.size();
+				effect.cb_slice_count = 1;
+			}
+
+			effect.cb_slice_index = 0;
+			effect.cb_slices_used_in_frame = 0;
+			effect.cb_slice_frame = std::numeric_limits<uint64_t>::max();
+			std::fill_n(effect.cb_set_frame, effect.cb_frames_in_flight, std::numeric_limits<uint64_t>::max());
+
 			if (!_device->create_resource(
-					api::resource_desc(effect.uniform_data_storage.size(), api::memory_heap::upload, api::resource_usage::constant_buffer),
+					api::resource_desc(effect.cb_slice_size * effect.cb_slice_count, api::memory_heap::upload, api::resource_usage::constant_buffer),
 					nullptr, api::resource_usage::cpu_access, &effect.cb))
 			{
 				log::message(log::level::error, "Failed to create constant buffer for effect file '%s'!", effect.source_file.u8string().c_str());
@@ -2382,26 +3180,42 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 			}
 
 			_device->set_resource_name(effect.cb, "ReShade constant buffer");
+
+			// Contents of the new buffer are undefined, so need to upload all uniform data before first use
+			effect.mark_uniform_data_dirty(0, effect.uniform_data_storage.size());
 		}
 		else
 		{
 			assert(effect.cb != 0);
 		}
 
-		if (!_device->allocate_descriptor_table(permutation.layout, 0, &permutation.cb_table))
+		permutation.cb_tables.resize(effect.cb_slice_count);
+
+		if (!_device->allocate_descriptor_tables(effect.cb_slice_count, permutation.layout, 0, permutation.cb_tables.data()))
 		{
+			permutation.cb_tables.clear();
+
 			log::message(log::level::error, "Failed to create constant buffer descriptor table for effect file '%s'!", effect.source_file.u8string().c_str());
 			goto exit_failure;
 		}
 
-		cb_buffer_range.buffer = effect.cb;
+		// Reserve all ranges up front, since the descriptor updates below point into this list until they are executed
+		cb_buffer_ranges.reserve(effect.cb_slice_count);
 
-		api::descriptor_table_update &write = descriptor_writes.emplace_back();
-		write.table = permutation.cb_table;
-		write.binding = 0;
-		write.type = api::descriptor_type::constant_buffer;
-		write.count = 1;
-		write.descriptors = &cb_buffer_range;
+		for (uint32_t slice_index = 0; slice_index < effect.cb_slice_count; ++slice_index)
+		{
+			api::buffer_range &cb_buffer_range = cb_buffer_ranges.emplace_back();
+			cb_buffer_range.buffer = effect.cb;
+			cb_buffer_range.offset = slice_index * effect.cb_slice_size;
+			cb_buffer_range.size = effect.uniform_data_storage.size();
+
+			api::descriptor_table_update &write = descriptor_writes.emplace_back();
+			write.table = permutation.cb_tables[slice_index];
+			write.binding = 0;
+			write.type = api::descriptor_type::constant_buffer;
+			write.count = 1;
+			write.descriptors = &cb_buffer_range;
+		}
 	}
 
 	if (sampler_range.count != 0)
@@ -2430,7 +3244,7 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 	}
 
 	// Initialize techniques and passes
-	for (size_t tech_index = 0, pass_index_in_effect = 0, query_base_index = 0; tech_index < _techniques.size(); ++tech_index)
+	for (size_t tech_index = 0, pass_index_in_effect = 0; tech_index < _techniques.size(); ++tech_index)
 	{
 		technique &tech = _techniques[tech_index];
 
@@ -2439,95 +3253,22 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 
 		assert(permutation_index < tech.permutations.size() && !tech.permutations[permutation_index].created);
 
-		// Offset index so that a query exists for each command frame and two subsequent ones are used for before/after stamps
-		if (permutation_index == 0)
-		{
-			tech.query_base_index = static_cast<uint32_t>(query_base_index);
-			query_base_index += (1 + tech.permutations[0].passes.size()) * 2 * 4;
-		}
-
 		for (size_t pass_index = 0; pass_index < tech.permutations[permutation_index].passes.size(); ++pass_index, ++pass_index_in_effect)
 		{
 			technique::pass &pass = tech.permutations[permutation_index].passes[pass_index];
 			pass.texture_table = shader_resource_view_tables[pass_index_in_effect];
 			pass.storage_table = unordered_access_view_tables[pass_index_in_effect];
 
-			std::vector<api::pipeline_subobject> subobjects;
-
-			if (!pass.cs_entry_point.empty())
+			if (pass.cs_entry_point.empty())
 			{
-				api::shader_desc cs_desc = {};
-				const std::string &cs = permutation.cso.at(pass.cs_entry_point);
-				cs_desc.code = cs.data();
-				cs_desc.code_size = cs.size();
-				if (_renderer_id & 0x20000)
+				if (pass.render_target_names[0].empty())
 				{
-					cs_desc.entry_point = pass.cs_entry_point.c_str();
-					cs_desc.spec_constants = static_cast<uint32_t>(permutation.module.spec_constants.size());
-					cs_desc.spec_constant_ids = spec_constants.data();
-					cs_desc.spec_constant_values = spec_data.data();
-				}
-
-				subobjects.push_back({ api::pipeline_subobject_type::compute_shader, 1, &cs_desc });
-
-				if (!_device->create_pipeline(permutation.layout, static_cast<uint32_t>(subobjects.size()), subobjects.data(), &pass.pipeline))
-				{
-					effect.errors += "error: internal compiler error";
-
-					log::message(log::level::error, "Failed to create compute pipeline for pass %zu in technique '%s' in '%s'!", pass_index, tech.name.c_str(), effect.source_file.u8string().c_str());
-					goto exit_failure;
-				}
-			}
-			else
-			{
-				api::shader_desc vs_desc = {};
-				if (!pass.vs_entry_point.empty())
-				{
-					const std::string &vs = permutation.cso.at(pass.vs_entry_point);
-					vs_desc.code = vs.data();
-					vs_desc.code_size = vs.size();
-					if (_renderer_id & 0x20000)
-					{
-						vs_desc.entry_point = pass.vs_entry_point.c_str();
-						vs_desc.spec_constants = static_cast<uint32_t>(permutation.module.spec_constants.size());
-						vs_desc.spec_constant_ids = spec_constants.data();
-						vs_desc.spec_constant_values = spec_data.data();
-					}
-
-					subobjects.push_back({ api::pipeline_subobject_type::vertex_shader, 1, &vs_desc });
-				}
-
-				api::shader_desc ps_desc = {};
-				if (!pass.ps_entry_point.empty())
-				{
-					const std::string &ps = permutation.cso.at(pass.ps_entry_point);
-					ps_desc.code = ps.data();
-					ps_desc.code_size = ps.size();
-					if (_renderer_id & 0x20000)
-					{
-						ps_desc.entry_point = pass.ps_entry_point.c_str();
-						ps_desc.spec_constants = static_cast<uint32_t>(permutation.module.spec_constants.size());
-						ps_desc.spec_constant_ids = spec_constants.data();
-						ps_desc.spec_constant_values = spec_data.data();
-					}
-
-					subobjects.push_back({ api::pipeline_subobject_type::pixel_shader, 1, &ps_desc });
-				}
-
-				api::format render_target_formats[8] = {};
-				if (pass.render_target_names[0].empty())
-				{
-					pass.viewport_width = _effect_permutations[permutation_index].width;
-					pass.viewport_height = _effect_permutations[permutation_index].height;
-
-					render_target_formats[0] = api::format_to_default_typed(_effect_permutations[permutation_index].color_format, pass.srgb_write_enable);
-
-					subobjects.push_back({ api::pipeline_subobject_type::render_target_formats, 1, &render_target_formats[0] });
+					pass.viewport_width = _effect_permutations[permutation_index].width;
+					pass.viewport_height = _effect_permutations[permutation_index].height;
 				}
 				else
 				{
-					int render_target_count = 0;
-					for (; render_target_count < 8 && !pass.render_target_names[render_target_count].empty(); ++render_target_count)
+					for (int render_target_count = 0; render_target_count < 8 && !pass.render_target_names[render_target_count].empty(); ++render_target_count)
 					{
 						const auto render_target_texture = std::find_if(_textures.cbegin(), _textures.cend(),
 							[&unique_name = pass.render_target_names[render_target_count]](const texture &item) {
@@ -2540,9 +3281,6 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 
 						pass.render_target_views[render_target_count] = rtv;
 
-						const api::resource_desc res_desc = _device->get_resource_desc(render_target_texture->resource);
-						render_target_formats[render_target_count] = api::format_to_default_typed(res_desc.texture.format, pass.srgb_write_enable);
-
 						if (std::find(pass.modified_resources.cbegin(), pass.modified_resources.cend(), render_target_texture->resource) == pass.modified_resources.cend())
 						{
 							pass.modified_resources.push_back(render_target_texture->resource);
@@ -2551,125 +3289,6 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 								pass.generate_mipmap_views.push_back(render_target_texture->srv[0]);
 						}
 					}
-
-					subobjects.push_back({ api::pipeline_subobject_type::render_target_formats, static_cast<uint32_t>(render_target_count), render_target_formats });
-				}
-
-				// Only need to attach stencil if stencil is actually used in this pass
-				if (pass.stencil_enable &&
-					pass.viewport_width == _effect_permutations[permutation_index].width &&
-					pass.viewport_height == _effect_permutations[permutation_index].height)
-				{
-					subobjects.push_back({ api::pipeline_subobject_type::depth_stencil_format, 1, &_effect_permutations[permutation_index].stencil_format });
-				}
-
-				subobjects.push_back({ api::pipeline_subobject_type::max_vertex_count, 1, &pass.num_vertices });
-
-				api::primitive_topology topology = static_cast<api::primitive_topology>(pass.topology);
-				subobjects.push_back({ api::pipeline_subobject_type::primitive_topology, 1, &topology });
-
-				const auto convert_blend_op = [](reshadefx::blend_op value) {
-					switch (value)
-					{
-					default:
-					case reshadefx::blend_op::add: return api::blend_op::add;
-					case reshadefx::blend_op::subtract: return api::blend_op::subtract;
-					case reshadefx::blend_op::reverse_subtract: return api::blend_op::reverse_subtract;
-					case reshadefx::blend_op::min: return api::blend_op::min;
-					case reshadefx::blend_op::max: return api::blend_op::max;
-					}
-				};
-				const auto convert_blend_factor = [](reshadefx::blend_factor value) {
-					switch (value) {
-					case reshadefx::blend_factor::zero: return api::blend_factor::zero;
-					default:
-					case reshadefx::blend_factor::one: return api::blend_factor::one;
-					case reshadefx::blend_factor::source_color: return api::blend_factor::source_color;
-					case reshadefx::blend_factor::one_minus_source_color: return api::blend_factor::one_minus_source_color;
-					case reshadefx::blend_factor::dest_color: return api::blend_factor::dest_color;
-					case reshadefx::blend_factor::one_minus_dest_color: return api::blend_factor::one_minus_dest_color;
-					case reshadefx::blend_factor::source_alpha: return api::blend_factor::source_alpha;
-					case reshadefx::blend_factor::one_minus_source_alpha: return api::blend_factor::one_minus_source_alpha;
-					case reshadefx::blend_factor::dest_alpha: return api::blend_factor::dest_alpha;
-					case reshadefx::blend_factor::one_minus_dest_alpha: return api::blend_factor::one_minus_dest_alpha;
-					}
-				};
-
-				// Technically should check for 'api::device_caps::independent_blend' support, but render target write masks are supported in D3D9, when rest is not, so just always set ...
-				api::blend_desc blend_state = {};
-				for (int i = 0; i < 8; ++i)
-				{
-					blend_state.blend_enable[i] = pass.blend_enable[i];
-					blend_state.source_color_blend_factor[i] = convert_blend_factor(pass.source_color_blend_factor[i]);
-					blend_state.dest_color_blend_factor[i] = convert_blend_factor(pass.dest_color_blend_factor[i]);
-					blend_state.color_blend_op[i] = convert_blend_op(pass.color_blend_op[i]);
-					blend_state.source_alpha_blend_factor[i] = convert_blend_factor(pass.source_alpha_blend_factor[i]);
-					blend_state.dest_alpha_blend_factor[i] = convert_blend_factor(pass.dest_alpha_blend_factor[i]);
-					blend_state.alpha_blend_op[i] = convert_blend_op(pass.alpha_blend_op[i]);
-					blend_state.render_target_write_mask[i] = pass.render_target_write_mask[i];
-				}
-
-				subobjects.push_back({ api::pipeline_subobject_type::blend_state, 1, &blend_state });
-
-				api::rasterizer_desc rasterizer_state = {};
-				rasterizer_state.cull_mode = api::cull_mode::none;
-
-				subobjects.push_back({ api::pipeline_subobject_type::rasterizer_state, 1, &rasterizer_state });
-
-				const auto convert_stencil_op = [](reshadefx::stencil_op value) {
-					switch (value) {
-					case reshadefx::stencil_op::zero: return api::stencil_op::zero;
-					default:
-					case reshadefx::stencil_op::keep: return api::stencil_op::keep;
-					case reshadefx::stencil_op::replace: return api::stencil_op::replace;
-					case reshadefx::stencil_op::increment_saturate: return api::stencil_op::increment_saturate;
-					case reshadefx::stencil_op::decrement_saturate: return api::stencil_op::decrement_saturate;
-					case reshadefx::stencil_op::invert: return api::stencil_op::invert;
-					case reshadefx::stencil_op::increment: return api::stencil_op::increment;
-					case reshadefx::stencil_op::decrement: return api::stencil_op::decrement;
-					}
-				};
-				const auto convert_stencil_func = [](reshadefx::stencil_func value) {
-					switch (value)
-					{
-					case reshadefx::stencil_func::never: return api::compare_op::never;
-					case reshadefx::stencil_func::less: return api::compare_op::less;
-					case reshadefx::stencil_func::equal: return api::compare_op::equal;
-					case reshadefx::stencil_func::less_equal: return api::compare_op::less_equal;
-					case reshadefx::stencil_func::greater: return api::compare_op::greater;
-					case reshadefx::stencil_func::not_equal: return api::compare_op::not_equal;
-					case reshadefx::stencil_func::greater_equal: return api::compare_op::greater_equal;
-					default:
-					case reshadefx::stencil_func::always: return api::compare_op::always;
-					}
-				};
-
-				api::depth_stencil_desc depth_stencil_state = {};
-				depth_stencil_state.depth_enable = false;
-				depth_stencil_state.depth_write_mask = false;
-				depth_stencil_state.depth_func = api::compare_op::always;
-				depth_stencil_state.stencil_enable = pass.stencil_enable;
-				depth_stencil_state.front_stencil_read_mask = pass.stencil_read_mask;
-				depth_stencil_state.front_stencil_write_mask = pass.stencil_write_mask;
-				depth_stencil_state.front_stencil_func = convert_stencil_func(pass.stencil_comparison_func);
-				depth_stencil_state.front_stencil_fail_op = convert_stencil_op(pass.stencil_fail_op);
-				depth_stencil_state.front_stencil_depth_fail_op = convert_stencil_op(pass.stencil_depth_fail_op);
-				depth_stencil_state.front_stencil_pass_op = convert_stencil_op(pass.stencil_pass_op);
-				depth_stencil_state.back_stencil_read_mask = depth_stencil_state.front_stencil_read_mask;
-				depth_stencil_state.back_stencil_write_mask = depth_stencil_state.front_stencil_write_mask;
-				depth_stencil_state.back_stencil_func = depth_stencil_state.front_stencil_func;
-				depth_stencil_state.back_stencil_fail_op = depth_stencil_state.front_stencil_fail_op;
-				depth_stencil_state.back_stencil_depth_fail_op = depth_stencil_state.front_stencil_depth_fail_op;
-				depth_stencil_state.back_stencil_pass_op = depth_stencil_state.front_stencil_pass_op;
-
-				subobjects.push_back({ api::pipeline_subobject_type::depth_stencil_state, 1, &depth_stencil_state });
-
-				if (!_device->create_pipeline(permutation.layout, static_cast<uint32_t>(subobjects.size()), subobjects.data(), &pass.pipeline))
-				{
-					effect.errors += "error: internal compiler error";
-
-					log::message(log::level::error, "Failed to create graphics pipeline for pass %zu in technique '%s' in '%s'!", pass_index, tech.name.c_str(), effect.source_file.u8string().c_str());
-					goto exit_failure;
 				}
 			}
 
@@ -2778,6 +3397,10 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 						sampler_with_resource_view ? sampler_descriptors[pass_index_in_effect * srv_range.count + binding.entry_point_binding].sampler : api::sampler { 0 },
 						binding.srgb
 					});
+
+					// Only passes that sample the back buffer need an up-to-date copy of it in the effect color texture (this includes other semantics that were bound to it)
+					if (srv == _effect_permutations[permutation_index].color_srv[0] || srv == _effect_permutations[permutation_index].color_srv[1])
+						pass.samples_back_buffer = true;
 				}
 				else
 				{
@@ -2817,7 +3440,28 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 			}
 		}
 
+		// Consecutive graphics passes that write to the exact same set of render targets can keep them in the render target state, instead of transitioning back and forth in between
+		// This is not done in D3D12, where there is no barrier that would only order the render target writes of the two passes without a state transition
+		std::vector<technique::pass> &passes = tech.permutations[permutation_index].passes;
+		for (size_t pass_index = 0; pass_index + 1 < passes.size() && _device->get_api() != api::device_api::d3d12; ++pass_index)
+		{
+			technique::pass &pass = passes[pass_index];
+			technique::pass &next_pass = passes[pass_index + 1];
+
+			if (pass.cs_entry_point.empty() && next_pass.cs_entry_point.empty() &&
+				pass.generate_mipmap_views.empty() && // Generating mipmaps requires the resources to be in shader resource state
+				!pass.modified_resources.empty() && pass.modified_resources == next_pass.modified_resources)
+			{
+				pass.skip_barriers_after = true;
+				next_pass.skip_barriers_before = true;
+			}
+		}
+
 		tech.permutations[permutation_index].created = true;
+
+		// Only create pipelines of techniques that are enabled right away, the others are created the first time they are rendered
+		if (tech.enabled && !create_technique_pipelines(tech, permutation_index))
+			goto exit_failure;
 	}
 
 	if (!descriptor_writes.empty())
@@ -2835,6 +3479,242 @@ exit_failure:
 
 	return false;
 }
+bool reshade::runtime::create_technique_pipelines(technique &tech, size_t permutation_index)
+{
+	effect &effect = _effects[tech.effect_index];
+	effect::permutation &permutation = effect.permutations[permutation_index];
+
+	assert(tech.permutations[permutation_index].created && !tech.permutations[permutation_index].pipelines_created);
+
+	// Build specialization constants
+	std::vector<uint32_t> spec_data;
+	std::vector<uint32_t> spec_constants;
+	for (const reshadefx::uniform &spec_constant : permutation.module.spec_constants)
+	{
+		uint32_t id = static_cast<uint32_t>(spec_constants.size());
+		spec_data.push_back(spec_constant.initializer_value.as_uint[0]);
+		spec_constants.push_back(id);
+	}
+
+	for (size_t pass_index = 0; pass_index < tech.permutations[permutation_index].passes.size(); ++pass_index)
+	{
+		technique::pass &pass = tech.permutations[permutation_index].passes[pass_index];
+
+		std::vector<api::pipeline_subobject> subobjects;
+
+		if (!pass.cs_entry_point.empty())
+		{
+			api::shader_desc cs_desc = {};
+			const std::string &cs = permutation.cso.at(pass.cs_entry_point);
+			cs_desc.code = cs.data();
+			cs_desc.code_size = cs.size();
+			if (_renderer_id & 0x20000)
+			{
+				cs_desc.entry_point = pass.cs_entry_point.c_str();
+				cs_desc.spec_constants = static_cast<uint32_t>(permutation.module.spec_constants.size());
+				cs_desc.spec_constant_ids = spec_constants.data();
+				cs_desc.spec_constant_values = spec_data.data();
+			}
+
+			subobjects.push_back({ api::pipeline_subobject_type::compute_shader, 1, &cs_desc });
+
+			if (!_device->create_pipeline(permutation.layout, static_cast<uint32_t>(subobjects.size()), subobjects.data(), &pass.pipeline))
+			{
+				effect.errors += "error: internal compiler error";
+
+				log::message(log::level::error, "Failed to create compute pipeline for pass %zu in technique '%s' in '%s'!", pass_index, tech.name.c_str(), effect.source_file.u8string().c_str());
+				goto exit_failure;
+			}
+		}
+		else
+		{
+			api::shader_desc vs_desc = {};
+			if (!pass.vs_entry_point.empty())
+			{
+				const std::string &vs = permutation.cso.at(pass.vs_entry_point);
+				vs_desc.code = vs.data();
+				vs_desc.code_size = vs.size();
+				if (_renderer_id & 0x20000)
+				{
+					vs_desc.entry_point = pass.vs_entry_point.c_str();
+					vs_desc.spec_constants = static_cast<uint32_t>(permutation.module.spec_constants.size());
+					vs_desc.spec_constant_ids = spec_constants.data();
+					vs_desc.spec_constant_values = spec_data.data();
+				}
+
+				subobjects.push_back({ api::pipeline_subobject_type::vertex_shader, 1, &vs_desc });
+			}
+
+			api::shader_desc ps_desc = {};
+			if (!pass.ps_entry_point.empty())
+			{
+				const std::string &ps = permutation.cso.at(pass.ps_entry_point);
+				ps_desc.code = ps.data();
+				ps_desc.code_size = ps.size();
+				if (_renderer_id & 0x20000)
+				{
+					ps_desc.entry_point = pass.ps_entry_point.c_str();
+					ps_desc.spec_constants = static_cast<uint32_t>(permutation.module.spec_constants.size());
+					ps_desc.spec_constant_ids = spec_constants.data();
+					ps_desc.spec_constant_values = spec_data.data();
+				}
+
+				subobjects.push_back({ api::pipeline_subobject_type::pixel_shader, 1, &ps_desc });
+			}
+
+			api::format render_target_formats[8] = {};
+			if (pass.render_target_names[0].empty())
+			{
+				render_target_formats[0] = api::format_to_default_typed(_effect_permutations[permutation_index].color_format, pass.srgb_write_enable);
+
+				subobjects.push_back({ api::pipeline_subobject_type::render_target_formats, 1, &render_target_formats[0] });
+			}
+			else
+			{
+				// Render target views were already set up in 'create_effect'
+				int render_target_count = 0;
+				for (; render_target_count < 8 && pass.render_target_views[render_target_count] != 0; ++render_target_count)
+				{
+					const api::resource_desc res_desc = _device->get_resource_desc(_device->get_resource_from_view(pass.render_target_views[render_target_count]));
+					render_target_formats[render_target_count] = api::format_to_default_typed(res_desc.texture.format, pass.srgb_write_enable);
+				}
+
+				subobjects.push_back({ api::pipeline_subobject_type::render_target_formats, static_cast<uint32_t>(render_target_count), render_target_formats });
+			}
+
+			// Only need to attach stencil if stencil is actually used in this pass
+			if (pass.stencil_enable &&
+				pass.viewport_width == _effect_permutations[permutation_index].width &&
+				pass.viewport_height == _effect_permutations[permutation_index].height)
+			{
+				subobjects.push_back({ api::pipeline_subobject_type::depth_stencil_format, 1, &_effect_permutations[permutation_index].stencil_format });
+			}
+
+			subobjects.push_back({ api::pipeline_subobject_type::max_vertex_count, 1, &pass.num_vertices });
+
+			api::primitive_topology topology = static_cast<api::primitive_topology>(pass.topology);
+			subobjects.push_back({ api::pipeline_subobject_type::primitive_topology, 1, &topology });
+
+			const auto convert_blend_op = [](reshadefx::blend_op value) {
+				switch (value)
+				{
+				default:
+				case reshadefx::blend_op::add: return api::blend_op::add;
+				case reshadefx::blend_op::subtract: return api::blend_op::subtract;
+				case reshadefx::blend_op::reverse_subtract: return api::blend_op::reverse_subtract;
+				case reshadefx::blend_op::min: return api::blend_op::min;
+				case reshadefx::blend_op::max: return api::blend_op::max;
+				}
+			};
+			const auto convert_blend_factor = [](reshadefx::blend_factor value) {
+				switch (value) {
+				case reshadefx::blend_factor::zero: return api::blend_factor::zero;
+				default:
+				case reshadefx::blend_factor::one: return api::blend_factor::one;
+				case reshadefx::blend_factor::source_color: return api::blend_factor::source_color;
+				case reshadefx::blend_factor::one_minus_source_color: return api::blend_factor::one_minus_source_color;
+				case reshadefx::blend_factor::dest_color: return api::blend_factor::dest_color;
+				case reshadefx::blend_factor::one_minus_dest_color: return api::blend_factor::one_minus_dest_color;
+				case reshadefx::blend_factor::source_alpha: return api::blend_factor::source_alpha;
+				case reshadefx::blend_factor::one_minus_source_alpha: return api::blend_factor::one_minus_source_alpha;
+				case reshadefx::blend_factor::dest_alpha: return api::blend_factor::dest_alpha;
+				case reshadefx::blend_factor::one_minus_dest_alpha: return api::blend_factor::one_minus_dest_alpha;
+				}
+			};
+
+			// Technically should check for 'api::device_caps::independent_blend' support, but render target write masks are supported in D3D9, when rest is not, so just always set ...
+			api::blend_desc blend_state = {};
+			for (int i = 0; i < 8; ++i)
+			{
+				blend_state.blend_enable[i] = pass.blend_enable[i];
+				blend_state.source_color_blend_factor[i] = convert_blend_factor(pass.source_color_blend_factor[i]);
+				blend_state.dest_color_blend_factor[i] = convert_blend_factor(pass.dest_color_blend_factor[i]);
+				blend_state.color_blend_op[i] = convert_blend_op(pass.color_blend_op[i]);
+				blend_state.source_alpha_blend_factor[i] = convert_blend_factor(pass.source_alpha_blend_factor[i]);
+				blend_state.dest_alpha_blend_factor[i] = convert_blend_factor(pass.dest_alpha_blend_factor[i]);
+				blend_state.alpha_blend_op[i] = convert_blend_op(pass.alpha_blend_op[i]);
+				blend_state.render_target_write_mask[i] = pass.render_target_write_mask[i];
+			}
+
+			subobjects.push_back({ api::pipeline_subobject_type::blend_state, 1, &blend_state });
+
+			api::rasterizer_desc rasterizer_state = {};
+			rasterizer_state.cull_mode = api::cull_mode::none;
+
+			subobjects.push_back({ api::pipeline_subobject_type::rasterizer_state, 1, &rasterizer_state });
+
+			const auto convert_stencil_op = [](reshadefx::stencil_op value) {
+				switch (value) {
+				case reshadefx::stencil_op::zero: return api::stencil_op::zero;
+				default:
+				case reshadefx::stencil_op::keep: return api::stencil_op::keep;
+				case reshadefx::stencil_op::replace: return api::stencil_op::replace;
+				case reshadefx::stencil_op::increment_saturate: return api::stencil_op::increment_saturate;
+				case reshadefx::stencil_op::decrement_saturate: return api::stencil_op::decrement_saturate;
+				case reshadefx::stencil_op::invert: return api::stencil_op::invert;
+				case reshadefx::stencil_op::increment: return api::stencil_op::increment;
+				case reshadefx::stencil_op::decrement: return api::stencil_op::decrement;
+				}
+			};
+			const auto convert_stencil_func = [](reshadefx::stencil_func value) {
+				switch (value)
+				{
+				case reshadefx::stencil_func::never: return api::compare_op::never;
+				case reshadefx::stencil_func::less: return api::compare_op::less;
+				case reshadefx::stencil_func::equal: return api::compare_op::equal;
+				case reshadefx::stencil_func::less_equal: return api::compare_op::less_equal;
+				case reshadefx::stencil_func::greater: return api::compare_op::greater;
+				case reshadefx::stencil_func::not_equal: return api::compare_op::not_equal;
+				case reshadefx::stencil_func::greater_equal: return api::compare_op::greater_equal;
+				default:
+				case reshadefx::stencil_func::always: return api::compare_op::always;
+				}
+			};
+
+			api::depth_stencil_desc depth_stencil_state = {};
+			depth_stencil_state.depth_enable = false;
+			depth_stencil_state.depth_write_mask = false;
+			depth_stencil_state.depth_func = api::compare_op::always;
+			depth_stencil_state.stencil_enable = pass.stencil_enable;
+			depth_stencil_state.front_stencil_read_mask = pass.stencil_read_mask;
+			depth_stencil_state.front_stencil_write_mask = pass.stencil_write_mask;
+			depth_stencil_state.front_stencil_func = convert_stencil_func(pass.stencil_comparison_func);
+			depth_stencil_state.front_stencil_fail_op = convert_stencil_op(pass.stencil_fail_op);
+			depth_stencil_state.front_stencil_depth_fail_op = convert_stencil_op(pass.stencil_depth_fail_op);
+			depth_stencil_state.front_stencil_pass_op = convert_stencil_op(pass.stencil_pass_op);
+			depth_stencil_state.back_stencil_read_mask = depth_stencil_state.front_stencil_read_mask;
+			depth_stencil_state.back_stencil_write_mask = depth_stencil_state.front_stencil_write_mask;
+			depth_stencil_state.back_stencil_func = depth_stencil_state.front_stencil_func;
+			depth_stencil_state.back_stencil_fail_op = depth_stencil_state.front_stencil_fail_op;
+			depth_stencil_state.back_stencil_depth_fail_op = depth_stencil_state.front_stencil_depth_fail_op;
+			depth_stencil_state.back_stencil_pass_op = depth_stencil_state.front_stencil_pass_op;
+
+			subobjects.push_back({ api::pipeline_subobject_type::depth_stencil_state, 1, &depth_stencil_state });
+
+			if (!_device->create_pipeline(permutation.layout, static_cast<uint32_t>(subobjects.size()), subobjects.data(), &pass.pipeline))
+			{
+				effect.errors += "error: internal compiler error";
+
+				log::message(log::level::error, "Failed to create graphics pipeline for pass %zu in technique '%s' in '%s'!", pass_index, tech.name.c_str(), effect.source_file.u8string().c_str());
+				goto exit_failure;
+			}
+		}
+	}
+
+	tech.permutations[permutation_index].pipelines_created = true;
+
+	return true;
+
+exit_failure:
+	// Destroy pipelines of the passes that were created successfully before the failing one
+	for (technique::pass &pass : tech.permutations[permutation_index].passes)
+	{
+		_device->destroy_pipeline(pass.pipeline);
+		pass.pipeline = {};
+	}
+
+	return false;
+}
 void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 {
 	assert(effect_index < _effects.size());
@@ -2859,9 +3739,14 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 				std::fill_n(pass.render_target_views, 8, api::resource_view {});
 				pass.modified_resources.clear();
 				pass.generate_mipmap_views.clear();
+
+				pass.samples_back_buffer = false;
+				pass.skip_barriers_before = false;
+				pass.skip_barriers_after = false;
 			}
 
 			permutation.created = false;
+			permutation.pipelines_created = false;
 		}
 	}
 
@@ -2870,13 +3755,10 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 		_device->destroy_resource(effect.cb);
 		effect.cb = {};
 
-		_device->destroy_query_heap(effect.query_heap);
-		effect.query_heap = {};
-
 		for (effect::permutation &permutation : effect.permutations)
 		{
-			_device->free_descriptor_table(permutation.cb_table);
-			permutation.cb_table = {};
+			_device->free_descriptor_tables(static_cast<uint32_t>(permutation.cb_tables.size()), permutation.cb_tables.data());
+			permutation.cb_tables.clear();
 			_device->free_descriptor_table(permutation.sampler_table);
 			permutation.sampler_table = {};
 
@@ -2898,6 +3780,15 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 	// No techniques from this effect are rendering anymore
 	effect.rendering = 0;
 
+	// Handles are about to be invalidated by removing textures and techniques below, so the lookup indices have to be rebuilt after this
+	_uniform_lookup_index.clear();
+	_texture_lookup_index.clear();
+	_technique_lookup_index.clear();
+
+	// Technique indices of timestamp queries still in flight are about to be invalidated as well, so discard those measurements
+	for (timestamp_frame &frame : _timestamp_frames)
+		frame.techniques.clear();
+
 	// Destroy textures belonging to this effect
 	_textures.erase(std::remove_if(_textures.begin(), _textures.end(),
 		[this, effect_index](texture &tex) {
@@ -2933,56 +3824,92 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 	// Do not clear effect here, since it is common to be reused immediately
 }
 
-void reshade::runtime::load_textures(size_t effect_index)
+static bool decode_texture_source(const std::filesystem::path &source_path, const reshade::texture &tex, reshade::texture_source &source, std::string &errors)
 {
-	for (texture &tex : _textures)
+	void *pixels = nullptr;
+	int width = 0, height = 1, depth = 1, channels = 0;
+	const bool is_floating_point_format =
+		tex.format == reshadefx::texture_format::r32f ||
+		tex.format == reshadefx::texture_format::rg32f ||
+		tex.format == reshadefx::texture_format::rgba32f;
+
+	if (FILE *const file = _wfsopen(source_path.c_str(), L"rb", SH_DENYNO))
 	{
-		if (tex.resource == 0 || !tex.semantic.empty())
-			continue; // Ignore textures that are not created yet and those that are handled in the runtime implementation
-		if (std::find(tex.shared.begin(), tex.shared.end(), effect_index) == tex.shared.end())
-			continue; // Ignore textures not being used with this effect
-
-		std::filesystem::path source_path = std::filesystem::u8path(tex.annotation_as_string("source"));
-		// Ignore textures that have no image file attached to them (e.g. plain render targets)
-		if (source_path.empty())
-			continue;
+		fseek(file, 0, SEEK_END);
+		const size_t file_size = ftell(file);
+		fseek(file, 0, SEEK_SET);
 
-		// Search for image file using the provided search paths unless the path provided is already absolute
-		if (!find_file(_texture_search_paths, source_path))
+		if (source_path.extension() == L".cube")
 		{
-			log::message(log::level::error, "Source '%s' for texture '%s' was not found in any of the texture search paths!", source_path.u8string().c_str(), tex.unique_name.c_str());
-			_last_reload_successful = false;
-			continue;
-		}
+			if (!is_floating_point_format)
+			{
+				fclose(file);
+				errors = "Source '" + source_path.u8string() + "' for texture '" + tex.unique_name + "' is a Cube LUT file, which can only be loaded into textures with a floating-point format!";
+				return false;
+			}
 
-		void *pixels = nullptr;
-		int width = 0, height = 1, depth = 1, channels = 0;
-		const bool is_floating_point_format =
-			tex.format == reshadefx::texture_format::r32f ||
-			tex.format == reshadefx::texture_format::rg32f ||
-			tex.format == reshadefx::texture_format::rgba32f;
+			float domain_min[3] = { 0.0f, 0.0f, 0.0f };
+			float domain_max[3] = { 1.0f, 1.0f, 1.0f };
 
-		if (FILE *const file = _wfsopen(source_path.c_str(), L"rb", SH_DENYNO))
-		{
-			fseek(file, 0, SEEK_END);
-			const size_t file_size = ftell(file);
-			fseek(file, 0, SEEK_SET);
-
-			if (source_path.extension() == L".cube")
+			// Read header information
+			char line_data[1024];
+			while (fgets(line_data, sizeof(line_data), file))
 			{
-				if (!is_floating_point_format)
+				const std::string_view line = trim(line_data, "\r\n");
+
+				if (line.empty() || line[0] == '#')
+					continue; // Skip lines with comments
+
+				char *p = line_data;
+
+				if (line.rfind("TITLE", 0) == 0)
+					continue; // Skip optional line with title
+
+				if (line.rfind("DOMAIN_MIN", 0) == 0)
 				{
-					log::message(log::level::error, "Source '%s' for texture '%s' is a Cube LUT file, which can only be loaded into textures with a floating-point format!", source_path.u8string().c_str(), tex.unique_name.c_str());
-					_last_reload_successful = false;
+					p += 10;
+					domain_min[0] = static_cast<float>(std::strtod(p, &p));
+					domain_min[1] = static_cast<float>(std::strtod(p, &p));
+					domain_min[2] = static_cast<float>(std::strtod(p, &p));
 					continue;
 				}
+				if (line.rfind("DOMAIN_MAX", 0) == 0)
+				{
+					p += 10;
+					domain_max[0] = static_cast<float>(std::strtod(p, &p));
+					domain_max[1] = static_cast<float>(std::strtod(p, &p));
+					domain_max[2] = static_cast<float>(std::strtod(p, &p));
+					continue;
+				}
+
+				if (line.rfind("LUT_1D_SIZE", 0) == 0)
+				{
+					if (pixels != nullptr)
+						break;
+					width = std::strtol(p + 11, nullptr, 10);
+					pixels = std::malloc(static_cast<size_t>(width) * 4 * sizeof(float));
+					continue;
+				}
+				if (line.rfind("LUT_3D_SIZE", 0) == 0)
+				{
+					if (pixels != nullptr)
+						break;
+					width = height = depth = std::strtol(p + 11, nullptr, 10);
+					pixels = std::malloc(static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4 * sizeof(float));
+					continue;
+				}
+
+				// Line has no known keyword, so assume this is where the table data starts and roll back a line to continue reading that below
+				fseek(file, -static_cast<long>(std::strlen(line_data)), SEEK_CUR);
+				break;
+			}
 
-				float domain_min[3] = { 0.0f, 0.0f, 0.0f };
-				float domain_max[3] = { 1.0f, 1.0f, 1.0f };
+			// Read table data
+			if (pixels != nullptr)
+			{
+				size_t index = 0;
 
-				// Read header information
-				char line_data[1024];
-				while (fgets(line_data, sizeof(line_data), file))
+				while (fgets(line_data, sizeof(line_data), file) && (index + 4) <= (static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4))
 				{
 					const std::string_view line = trim(line_data, "\r\n");
 
@@ -2991,133 +3918,173 @@ void reshade::runtime::load_textures(size_t effect_index)
 
 					char *p = line_data;
 
-					if (line.rfind("TITLE", 0) == 0)
-						continue; // Skip optional line with title
+					static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[0] - domain_min[0]) + domain_min[0];
+					static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[1] - domain_min[1]) + domain_min[1];
+					static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[2] - domain_min[2]) + domain_min[2];
+					static_cast<float *>(pixels)[index++] = 1.0f;
+				}
+			}
 
-					if (line.rfind("DOMAIN_MIN", 0) == 0)
-					{
-						p += 10;
-						domain_min[0] = static_cast<float>(std::strtod(p, &p));
-						domain_min[1] = static_cast<float>(std::strtod(p, &p));
-						domain_min[2] = static_cast<float>(std::strtod(p, &p));
-						continue;
-					}
-					if (line.rfind("DOMAIN_MAX", 0) == 0)
-					{
-						p += 10;
-						domain_max[0] = static_cast<float>(std::strtod(p, &p));
-						domain_max[1] = static_cast<float>(std::strtod(p, &p));
-						domain_max[2] = static_cast<float>(std::strtod(p, &p));
-						continue;
-					}
+			fclose(file);
+		}
+		else
+		{
+			// Read texture data into memory in one go since that is faster than reading chunk by chunk
+			std::vector<stbi_uc> file_data(file_size);
+			const size_t file_size_read = fread(file_data.data(), 1, file_size, file);
+			fclose(file);
 
-					if (line.rfind("LUT_1D_SIZE", 0) == 0)
-					{
-						if (pixels != nullptr)
-							break;
-						width = std::strtol(p + 11, nullptr, 10);
-						pixels = std::malloc(static_cast<size_t>(width) * 4 * sizeof(float));
-						continue;
-					}
-					if (line.rfind("LUT_3D_SIZE", 0) == 0)
-					{
-						if (pixels != nullptr)
-							break;
-						width = height = depth = std::strtol(p + 11, nullptr, 10);
-						pixels = std::malloc(static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4 * sizeof(float));
-						continue;
-					}
+			if (file_size_read == file_size)
+			{
+				if (is_floating_point_format)
+					pixels = stbi_loadf_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+				else if (stbi_dds_test_memory(file_data.data(), static_cast<int>(file_data.size())))
+					pixels = stbi_dds_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &depth, &channels, STBI_rgb_alpha);
+				else
+					pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+			}
+		}
+	}
 
-					// Line has no known keyword, so assume this is where the table data starts and roll back a line to continue reading that below
-					fseek(file, -static_cast<long>(std::strlen(line_data)), SEEK_CUR);
-					break;
-				}
+	if (pixels == nullptr)
+	{
+		errors = "Failed to load '" + source_path.u8string() + "' for texture '" + tex.unique_name + "'!";
+		return false;
+	}
 
-				// Read table data
-				if (pixels != nullptr)
-				{
-					size_t index = 0;
+	// Collapse data to the correct number of components per pixel based on the texture format
+	size_t pixel_size = 0;
+	switch (tex.format)
+	{
+	case reshadefx::texture_format::r8:
+		pixel_size = 1 * 1;
+		for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
+			static_cast<stbi_uc *>(pixels)[k] = static_cast<stbi_uc *>(pixels)[i];
+		break;
+	case reshadefx::texture_format::r32f:
+		pixel_size = 4 * 1;
+		for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
+			static_cast<float *>(pixels)[k] = static_cast<float *>(pixels)[i];
+		break;
+	case reshadefx::texture_format::rg8:
+		pixel_size = 1 * 2;
+		for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
+			static_cast<stbi_uc *>(pixels)[k + 0] = static_cast<stbi_uc *>(pixels)[i + 0],
+			static_cast<stbi_uc *>(pixels)[k + 1] = static_cast<stbi_uc *>(pixels)[i + 1];
+		break;
+	case reshadefx::texture_format::rg32f:
+		pixel_size = 4 * 2;
+		for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
+			static_cast<float *>(pixels)[k + 0] = static_cast<float *>(pixels)[i + 0],
+			static_cast<float *>(pixels)[k + 1] = static_cast<float *>(pixels)[i + 1];
+		break;
+	case reshadefx::texture_format::rgba8:
+		pixel_size = 1 * 4;
+		break;
+	case reshadefx::texture_format::rgba32f:
+		pixel_size = 4 * 4;
+		break;
+	default:
+		errors = "Texture upload is not supported for format " + std::to_string(static_cast<int>(tex.format)) + " of texture '" + tex.unique_name + "'!";
+		stbi_image_free(pixels);
+		return false;
+	}
 
-					while (fgets(line_data, sizeof(line_data), file) && (index + 4) <= (static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4))
-					{
-						const std::string_view line = trim(line_data, "\r\n");
+	source.width = static_cast<uint32_t>(width);
+	source.height = static_cast<uint32_t>(height);
+	source.depth = static_cast<uint32_t>(depth);
+	source.pixels.assign(static_cast<const uint8_t *>(pixels), static_cast<const uint8_t *>(pixels) + static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * pixel_size);
 
-						if (line.empty() || line[0] == '#')
-							continue; // Skip lines with comments
+	stbi_image_free(pixels);
 
-						char *p = line_data;
+	return true;
+}
 
-						static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[0] - domain_min[0]) + domain_min[0];
-						static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[1] - domain_min[1]) + domain_min[1];
-						static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[2] - domain_min[2]) + domain_min[2];
-						static_cast<float *>(pixels)[index++] = 1.0f;
-					}
-				}
-			}
-			else
-			{
-				// Read texture data into memory in one go since that is faster than reading chunk by chunk
-				std::vector<stbi_uc> file_data(file_size);
-				const size_t file_size_read = fread(file_data.data(), 1, file_size, file);
-				fclose(file);
+void reshade::runtime::load_textures(size_t effect_index)
+{
+	for (texture &tex : _textures)
+	{
+		if (tex.resource == 0 || !tex.semantic.empty())
+			continue; // Ignore textures that are not created yet and those that are handled in the runtime implementation
+		if (std::find(tex.shared.begin(), tex.shared.end(), effect_index) == tex.shared.end())
+			continue; // Ignore textures not being used with this effect
 
-				if (file_size_read == file_size)
-				{
-					if (is_floating_point_format)
-						pixels = stbi_loadf_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
-					else if (stbi_dds_test_memory(file_data.data(), static_cast<int>(file_data.size())))
-						pixels = stbi_dds_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &depth, &channels, STBI_rgb_alpha);
-					else
-						pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
-				}
-			}
-		}
+		std::filesystem::path source_path = std::filesystem::u8path(tex.annotation_as_string("source"));
+		// Ignore textures that have no image file attached to them (e.g. plain render targets)
+		if (source_path.empty())
+			continue;
 
-		if (pixels == nullptr)
+		// Search for image file using the provided search paths unless the path provided is already absolute
+		if (!find_file(_texture_search_paths, source_path))
 		{
-			log::message(log::level::error, "Failed to load '%s' for texture '%s'!", source_path.u8string().c_str(), tex.unique_name.c_str());
+			log::message(log::level::error, "Source '%s' for texture '%s' was not found in any of the texture search paths!", source_path.u8string().c_str(), tex.unique_name.c_str());
 			_last_reload_successful = false;
 			continue;
 		}
 
-		// Collapse data to the correct number of components per pixel based on the texture format
-		switch (tex.format)
+		std::string errors;
+		const std::shared_ptr<const texture_source> source = load_texture_source(tex, source_path, errors);
+		if (source == nullptr)
 		{
-		case reshadefx::texture_format::r8:
-			for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
-				static_cast<stbi_uc *>(pixels)[k] = static_cast<stbi_uc *>(pixels)[i];
-			break;
-		case reshadefx::texture_format::r32f:
-			for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
-				static_cast<float *>(pixels)[k] = static_cast<float *>(pixels)[i];
-			break;
-		case reshadefx::texture_format::rg8:
-			for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
-				static_cast<stbi_uc *>(pixels)[k + 0] = static_cast<stbi_uc *>(pixels)[i + 0],
-				static_cast<stbi_uc *>(pixels)[k + 1] = static_cast<stbi_uc *>(pixels)[i + 1];
-			break;
-		case reshadefx::texture_format::rg32f:
-			for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
-				static_cast<float *>(pixels)[k + 0] = static_cast<float *>(pixels)[i + 0],
-				static_cast<float *>(pixels)[k + 1] = static_cast<float *>(pixels)[i + 1];
-			break;
-		case reshadefx::texture_format::rgba8:
-		case reshadefx::texture_format::rgba32f:
-			break;
-		default:
-			log::message(log::level::error, "Texture upload is not supported for format %d of texture '%s'!", static_cast<int>(tex.format), tex.unique_name.c_str());
+			log::message(log::level::error, "%s", errors.c_str());
 			_last_reload_successful = false;
-			stbi_image_free(pixels);
 			continue;
 		}
 
-		update_texture(tex, width, height, depth, pixels);
-
-		stbi_image_free(pixels);
+		update_texture(tex, source->width, source->height, source->depth, source->pixels.data());
 
 		tex.loaded = true;
 	}
 }
+std::shared_ptr<const reshade::texture_source> reshade::runtime::load_texture_source(const texture &tex, const std::filesystem::path &source_path, std::string &errors)
+{
+	std::error_code ec;
+	const std::filesystem::file_time_type last_write_time = std::filesystem::last_write_time(source_path, ec);
+
+	if (!ec)
+	{
+		const std::unique_lock<std::mutex> lock(_texture_source_cache_mutex);
+
+		if (const auto it = std::find_if(_texture_source_cache.begin(), _texture_source_cache.end(),
+				[&tex, &source_path, last_write_time](const std::shared_ptr<const texture_source> &item) {
+					return item->format == tex.format && item->last_write_time == last_write_time && item->source_file == source_path;
+				});
+			it != _texture_source_cache.end())
+		{
+			// Move entry to the end of the list, so that the least recently used ones are evicted first
+			std::rotate(it, std::next(it), _texture_source_cache.end());
+			return _texture_source_cache.back();
+		}
+	}
+
+	const std::shared_ptr<texture_source> source = std::make_shared<texture_source>();
+	source->source_file = source_path;
+	source->last_write_time = last_write_time;
+	source->format = tex.format;
+
+	if (!decode_texture_source(source_path, tex, *source, errors))
+		return nullptr;
+
+	// Do not cache the result if the modification time is unknown, since it would then not be possible to tell whether the file changed
+	if (!ec && _texture_source_cache_size != 0)
+	{
+		const std::unique_lock<std::mutex> lock(_texture_source_cache_mutex);
+
+		_texture_source_cache.push_back(source);
+
+		size_t total_size = 0;
+		for (const std::shared_ptr<const texture_source> &item : _texture_source_cache)
+			total_size += item->pixels.size();
+
+		while (total_size > static_cast<size_t>(_texture_source_cache_size) * 1024 * 1024)
+		{
+			total_size -= _texture_source_cache.front()->pixels.size();
+			_texture_source_cache.erase(_texture_source_cache.begin());
+		}
+	}
+
+	return source;
+}
 bool reshade::runtime::create_texture(texture &tex)
 {
 	// Do not create resource if it is a special reference, those are set in 'render_technique' and 'update_texture_bindings'
@@ -3240,13 +4207,55 @@ bool reshade::runtime::create_texture(texture &tex)
 		}
 	}
 
-	if (!_device->create_resource(api::resource_desc(type, tex.width, tex.height, tex.depth, tex.levels, format, 1, api::memory_heap::default_, usage, flags), initial_data.data(), api::resource_usage::shader_resource, &tex.resource))
+	const api::resource_desc desc(type, tex.width, tex.height, tex.depth, tex.levels, format, 1, api::memory_heap::default_, usage, flags);
+
+	// Transient textures used by different techniques are never live at the same time, so they can share the same resource if their description matches
+	transient_texture_allocation *transient_allocation = nullptr;
+	if (!tex.transient_technique.empty())
 	{
-		log::message(log::level::error, "Failed to create texture '%s' (width = %u, height = %u, levels = %hu, format = %u, usage = %#x)! Make sure the texture dimensions are reasonable.", tex.unique_name.c_str(), tex.width, tex.height, tex.levels, static_cast<uint32_t>(format), static_cast<uint32_t>(usage));
-		return false;
+		const size_t effect_index = tex.shared[0];
+
+		if (const auto it = std::find_if(_transient_textures.begin(), _transient_textures.end(),
+				[&desc, &tex, effect_index](const transient_texture_allocation &allocation) {
+					return
+						allocation.desc.type == desc.type &&
+						allocation.desc.texture.width == desc.texture.width &&
+						allocation.desc.texture.height == desc.texture.height &&
+						allocation.desc.texture.depth_or_layers == desc.texture.depth_or_layers &&
+						allocation.desc.texture.levels == desc.texture.levels &&
+						allocation.desc.texture.format == desc.texture.format &&
+						allocation.desc.usage == desc.usage &&
+						std::none_of(allocation.users.cbegin(), allocation.users.cend(),
+							[&tex, effect_index](const transient_texture_allocation::user &user) { return user.effect_index == effect_index && user.technique_name == tex.transient_technique; });
+				});
+			it != _transient_textures.end())
+			transient_allocation = &*it;
+	}
+
+	if (transient_allocation != nullptr)
+	{
+		tex.resource = transient_allocation->resource;
 	}
+	else
+	{
+		if (!_device->create_resource(desc, initial_data.data(), api::resource_usage::shader_resource, &tex.resource))
+		{
+			log::message(log::level::error, "Failed to create texture '%s' (width = %u, height = %u, levels = %hu, format = %u, usage = %#x)! Make sure the texture dimensions are reasonable.", tex.unique_name.c_str(), tex.width, tex.height, tex.levels, static_cast<uint32_t>(format), static_cast<uint32_t>(usage));
+			return false;
+		}
 
-	_device->set_resource_name(tex.resource, tex.unique_name.c_str());
+		_device->set_resource_name(tex.resource, tex.unique_name.c_str());
+
+		if (!tex.transient_technique.empty())
+		{
+			transient_allocation = &_transient_textures.emplace_back();
+			transient_allocation->resource = tex.resource;
+			transient_allocation->desc = desc;
+		}
+	}
+
+	if (transient_allocation != nullptr)
+		transient_allocation->users.push_back({ tex.unique_name, tex.shared[0], tex.transient_technique });
 
 	// Always create shader resource views
 	{
@@ -3306,12 +4315,29 @@ bool reshade::runtime::create_texture(texture &tex)
 			}
 		}
 	}
-
-	return true;
-}
-void reshade::runtime::destroy_texture(texture &tex)
-{
-	_device->destroy_resource(tex.resource);
+
+	return true;
+}
+void reshade::runtime::destroy_texture(texture &tex)
+{
+	if (const auto allocation = std::find_if(_transient_textures.begin(), _transient_textures.end(),
+			[&tex](const transient_texture_allocation &item) { return item.resource == tex.resource; });
+		tex.resource != 0 && allocation != _transient_textures.end())
+	{
+		allocation->users.erase(std::remove_if(allocation->users.begin(), allocation->users.end(),
+			[&tex](const transient_texture_allocation::user &user) { return user.texture_name == tex.unique_name; }), allocation->users.end());
+
+		// Only destroy the shared resource once the last texture aliasing it is gone
+		if (allocation->users.empty())
+		{
+			_device->destroy_resource(allocation->resource);
+			_transient_textures.erase(allocation);
+		}
+	}
+	else
+	{
+		_device->destroy_resource(tex.resource);
+	}
 	tex.resource = {};
 
 	_device->destroy_resource_view(tex.srv[0]);
@@ -3434,9 +4460,23 @@ void reshade::runtime::load_effects(bool force_load_all)
 	_effects.resize(offset + effect_files.size());
 	_reload_remaining_effects = effect_files.size();
 
+	// Start with an empty include cache on every reload, so that changes to include files are picked up
+	_effect_include_cache = std::make_unique<reshadefx::include_cache>();
+
+	// Seed the driver pipeline cache from disk before the first effects are created, so that their pipelines do not have to be compiled by the driver again
+	if (_device->get_api() == api::device_api::vulkan && !_effect_pipeline_cache_loaded)
+	{
+		_effect_pipeline_cache_loaded = true;
+
+		if (std::string pipeline_cache_data;
+			load_effect_cache("vulkan-" + std::to_string(_vendor_id) + '-' + std::to_string(_device_id), "pipelines", pipeline_cache_data))
+			static_cast<vulkan::device_impl *>(_device)->merge_pipeline_cache_data(pipeline_cache_data);
+	}
+
 	// Now that we have a list of files, load them in parallel
 	// Split workload into batches instead of launching a thread for every file to avoid launch overhead and stutters due to too many threads being in flight
-	size_t num_splits = std::min(effect_files.size(), static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 2u) - 1));
+	// Every batch preprocesses and parses on two threads at once (see 'load_effect'), so only use half as many batches as there are hardware threads
+	size_t num_splits = std::min(effect_files.size(), static_cast<size_t>(std::max(std::thread::hardware_concurrency() / 2, 2u) - 1));
 #ifndef _WIN64
 	// Limit number of threads in 32-bit due to the limited about of address space being available there and compilation being memory hungry
 	num_splits = std::min(num_splits, static_cast<size_t>(4));
@@ -3465,6 +4505,8 @@ bool reshade::runtime::reload_effect(size_t effect_index)
 	const std::filesystem::path source_file = _effects[effect_index].source_file;
 	destroy_effect(effect_index);
 
+	update_effect_lookup_indices();
+
 #if RESHADE_ADDON
 	// Call event after destroying the effect, so add-ons get a chance to release any handles they hold to variables and techniques
 	invoke_addon_event<addon_event::reshade_reloaded_effects>(this);
@@ -3477,11 +4519,15 @@ bool reshade::runtime::reload_effect(size_t effect_index)
 }
 void reshade::runtime::reload_effects(bool force_load_all)
 {
-	// Clear out any previous effects
-	destroy_effects();
+	// Keep the current effects rendering while the new ones are loaded in the background, unless they did not finish loading themselves yet
+	if (_effect_background_reload && !is_loading() && !_techniques.empty())
+		retire_effects();
+	else
+		// Clear out any previous effects
+		destroy_effects();
 
 #if RESHADE_ADDON
-	// Call event after destroying previous effects, so add-ons get a chance to release any handles they hold to variables and techniques
+	// Call event after destroying or retiring previous effects, so add-ons get a chance to release any handles they hold to variables and techniques
 	invoke_addon_event<addon_event::reshade_reloaded_effects>(this);
 #endif
 
@@ -3494,6 +4540,100 @@ void reshade::runtime::reload_effects(bool force_load_all)
 
 	load_effects(force_load_all);
 }
+void reshade::runtime::reload_effects(const std::vector<size_t> &effect_indices)
+{
+	assert(!is_loading());
+
+#if RESHADE_GUI
+	_show_splash = false; // Hide splash bar when only reloading some effect files
+#endif
+
+	// Make sure no effect resources are currently in use
+	_graphics_queue->wait_idle();
+
+	for (const size_t effect_index : effect_indices)
+	{
+		destroy_effect(effect_index);
+
+		// Force the effect to be compiled again, even if its source hash did not change (e.g. because only specialization constants changed)
+		_effects[effect_index].compiled = false;
+		_effects[effect_index].preprocessed = false;
+
+		_reload_create_queue.erase(std::remove_if(_reload_create_queue.begin(), _reload_create_queue.end(),
+			[effect_index](const std::pair<size_t, size_t> &item) { return item.first == effect_index; }), _reload_create_queue.end());
+	}
+
+	update_effect_lookup_indices();
+
+#if RESHADE_ADDON
+	// Call event after destroying the effects, so add-ons get a chance to release any handles they hold to variables and techniques
+	invoke_addon_event<addon_event::reshade_reloaded_effects>(this);
+#endif
+
+	for (std::thread &thread : _worker_threads)
+		if (thread.joinable())
+			thread.join();
+	_worker_threads.clear();
+
+	ini_file &preset = ini_file::load_cache(_current_preset_path);
+
+	_reload_remaining_effects = effect_indices.size();
+
+	// Load the affected effects in the background, which will pick up a compiled variant from the cache if one exists for the new preset
+	size_t num_splits = std::min(effect_indices.size(), static_cast<size_t>(std::max(std::thread::hardware_concurrency() / 2, 2u) - 1));
+#ifndef _WIN64
+	num_splits = std::min(num_splits, static_cast<size_t>(4));
+#endif
+
+	for (size_t n = 0; n < num_splits; ++n)
+		_worker_threads.emplace_back([this, effect_indices, num_splits, n, &preset]() {
+			for (size_t i = 0; i < effect_indices.size() && _is_initialized; ++i)
+			{
+				if (i * num_splits / effect_indices.size() == n)
+				{
+					const std::filesystem::path source_file = _effects[effect_indices[i]].source_file;
+					load_effect(source_file, preset, effect_indices[i], 0);
+				}
+			}
+		});
+}
+void reshade::runtime::precompile_effect_variants(const std::vector<size_t> &effect_indices)
+{
+	assert(!is_loading() && _precompile_effect_indices.empty());
+
+	for (std::thread &thread : _worker_threads)
+		if (thread.joinable())
+			thread.join();
+	_worker_threads.clear();
+
+	std::vector<std::filesystem::path> source_files;
+	source_files.reserve(effect_indices.size());
+	for (const size_t effect_index : effect_indices)
+		source_files.push_back(_effects[effect_index].source_file);
+
+	ini_file &preset = ini_file::load_cache(_current_preset_path);
+
+	_precompile_effect_indices = effect_indices;
+	_precompile_remaining_effects = effect_indices.size();
+
+	// Compile the variants into the variant cache only, the effects are then reloaded from there in 'update_effects' once all of them are done
+	size_t num_splits = std::min(effect_indices.size(), static_cast<size_t>(std::max(std::thread::hardware_concurrency() / 2, 2u) - 1));
+#ifndef _WIN64
+	num_splits = std::min(num_splits, static_cast<size_t>(4));
+#endif
+
+	for (size_t n = 0; n < num_splits; ++n)
+		_worker_threads.emplace_back([this, effect_indices, source_files = source_files, num_splits, n, &preset]() {
+			for (size_t i = 0; i < effect_indices.size() && _is_initialized; ++i)
+			{
+				if (i * num_splits / effect_indices.size() == n)
+				{
+					load_effect(source_files[i], preset, effect_indices[i], 0, true, false, true);
+					_precompile_remaining_effects--;
+				}
+			}
+		});
+}
 void reshade::runtime::destroy_effects()
 {
 	// Make sure no threads are still accessing effect data
@@ -3502,6 +4642,15 @@ void reshade::runtime::destroy_effects()
 			thread.join();
 	_worker_threads.clear();
 
+	// Effects that were waiting for their variants are reloaded from scratch anyway
+	_precompile_effect_indices.clear();
+
+	// Finish writing the pipeline cache before the device may go away
+	if (_pipeline_cache_save_thread.joinable())
+		_pipeline_cache_save_thread.join();
+
+	_effect_include_cache.reset();
+
 #if RESHADE_GUI
 	_effect_filter[0] = '\0';
 	_preview_texture = std::numeric_limits<size_t>::max();
@@ -3515,6 +4664,9 @@ void reshade::runtime::destroy_effects()
 	// Make sure no effect resources are currently in use (do this even when the effect list is empty, since it is dependent upon by 'on_reset')
 	_graphics_queue->wait_idle();
 
+	// Destroy previous effects still rendering during a background reload too, before the sampler objects they use are destroyed below
+	destroy_retired_effects();
+
 	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
 		destroy_effect(effect_index);
 
@@ -3528,7 +4680,118 @@ void reshade::runtime::destroy_effects()
 
 	// Textures and techniques should have been cleaned up by the calls to 'destroy_effect' above
 	assert(_textures.empty());
+	assert(_transient_textures.empty());
+	assert(_techniques.empty() && _technique_sorting.empty());
+}
+void reshade::runtime::retire_effects()
+{
+	// Effects retired by a previous reload may still be waiting for the GPU to finish with them
+	destroy_retired_effects();
+
+	assert(!is_loading() && _retired_effects.empty());
+
+	// Make sure no threads are still accessing effect data
+	for (std::thread &thread : _worker_threads)
+		if (thread.joinable())
+			thread.join();
+	_worker_threads.clear();
+
+	_effect_include_cache.reset();
+
+#if RESHADE_GUI
+	_effect_filter[0] = '\0';
+	_preview_texture = std::numeric_limits<size_t>::max();
+#endif
+
+	_reload_required_effects.clear();
+	_precompile_effect_indices.clear();
+
+	// Handles to the retired effects cannot be looked up anymore, they are rebuilt for the new effects once those finished loading
+	_uniform_lookup_index.clear();
+	_texture_lookup_index.clear();
+	_technique_lookup_index.clear();
+
+	// Technique indices of timestamp queries still in flight refer to the retired effects, so discard those measurements
+	for (timestamp_frame &frame : _timestamp_frames)
+		frame.techniques.clear();
+
+	// Move current effects out of the way, so that new ones are loaded into empty lists while these keep rendering
+	swap_retired_effects();
+}
+void reshade::runtime::destroy_retired_effects()
+{
+	if (_retired_effects.empty())
+		return;
+
+	// Make sure no resources of the retired effects are currently in use (which is usually known from the frame fence already, so that this does not have to wait)
+	if (_frame_fence == 0 || _retired_effects_last_frame == std::numeric_limits<uint64_t>::max() || _device->get_completed_fence_value(_frame_fence) <= _retired_effects_last_frame)
+		_graphics_queue->wait_idle();
+
+	_retired_effects_last_frame = std::numeric_limits<uint64_t>::max();
+
+	swap_retired_effects();
+
+	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+		destroy_effect(effect_index);
+
+	_effects.clear();
+
+	assert(_textures.empty());
+	assert(_transient_textures.empty());
 	assert(_techniques.empty() && _technique_sorting.empty());
+
+	swap_retired_effects();
+}
+void reshade::runtime::swap_retired_effects()
+{
+	_effects.swap(_retired_effects);
+	_textures.swap(_retired_textures);
+	_transient_textures.swap(_retired_transient_textures);
+	_techniques.swap(_retired_techniques);
+	_technique_sorting.swap(_retired_technique_sorting);
+}
+void reshade::runtime::update_effect_lookup_indices()
+{
+	_uniform_lookup_index.clear();
+	_texture_lookup_index.clear();
+	_technique_lookup_index.clear();
+
+	// Fill in all names before adding any entries, since those reference them
+	_effect_lookup_names.resize(_effects.size());
+	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+		_effect_lookup_names[effect_index] = _effects[effect_index].source_file.filename().u8string();
+
+	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+	{
+		const std::string &effect_name = _effect_lookup_names[effect_index];
+		// Only the first effect with a given file name is searched for uniform variables when looking up by effect name
+		const bool first_with_name = std::find(_effect_lookup_names.cbegin(), _effect_lookup_names.cbegin() + effect_index, effect_name) == _effect_lookup_names.cbegin() + effect_index;
+
+		for (const uniform &variable : _effects[effect_index].uniforms)
+		{
+			if (first_with_name)
+				_uniform_lookup_index.insert(effect_name, variable.name, reinterpret_cast<uintptr_t>(&variable));
+			_uniform_lookup_index.insert({}, variable.name, reinterpret_cast<uintptr_t>(&variable));
+		}
+	}
+
+	for (const texture &variable : _textures)
+	{
+		for (const size_t effect_index : variable.shared)
+		{
+			_texture_lookup_index.insert(_effect_lookup_names[effect_index], variable.name, reinterpret_cast<uintptr_t>(&variable));
+			_texture_lookup_index.insert(_effect_lookup_names[effect_index], variable.unique_name, reinterpret_cast<uintptr_t>(&variable));
+		}
+
+		_texture_lookup_index.insert({}, variable.name, reinterpret_cast<uintptr_t>(&variable));
+		_texture_lookup_index.insert({}, variable.unique_name, reinterpret_cast<uintptr_t>(&variable));
+	}
+
+	for (const technique &tech : _techniques)
+	{
+		_technique_lookup_index.insert(_effect_lookup_names[tech.effect_index], tech.name, reinterpret_cast<uintptr_t>(&tech));
+		_technique_lookup_index.insert({}, tech.name, reinterpret_cast<uintptr_t>(&tech));
+	}
 }
 
 bool reshade::runtime::load_effect_cache(const std::string &id, const std::string &type, std::string &data) const
@@ -3568,8 +4831,30 @@ bool reshade::runtime::save_effect_cache(const std::string &id, const std::strin
 	fclose(file);
 	return file_size_written == data.size();
 }
+void reshade::runtime::save_pipeline_cache()
+{
+	_pipeline_cache_dirty = false;
+
+	if (_device->get_api() != api::device_api::vulkan)
+		return;
+
+	// Only ever have a single write in flight, so that writes to the cache file cannot overlap
+	if (_pipeline_cache_save_thread.joinable())
+		_pipeline_cache_save_thread.join();
+
+	_pipeline_cache_save_thread = std::thread([this]() {
+		if (std::string pipeline_cache_data;
+			static_cast<vulkan::device_impl *>(_device)->get_pipeline_cache_data(pipeline_cache_data))
+			save_effect_cache("vulkan-" + std::to_string(_vendor_id) + '-' + std::to_string(_device_id), "pipelines", pipeline_cache_data);
+	});
+}
 void reshade::runtime::clear_effect_cache()
 {
+	{
+		const std::unique_lock<std::mutex> lock(_effect_variant_cache_mutex);
+		_effect_variant_cache.clear();
+	}
+
 	std::error_code ec;
 
 	// Find all cached effect files and delete them
@@ -3580,7 +4865,7 @@ void reshade::runtime::clear_effect_cache()
 
 		const std::filesystem::path filename = entry.path().filename();
 		const std::filesystem::path extension = entry.path().extension();
-		if (filename.wstring().compare(0, 8, L"reshade-") != 0 || (extension != L".i" && extension != L".cso" && extension != L".asm"))
+		if (filename.wstring().compare(0, 8, L"reshade-") != 0 || (extension != L".i" && extension != L".cso" && extension != L".asm" && extension != L".module" && extension != L".pipelines"))
 			continue;
 
 		std::filesystem::remove(entry, ec);
@@ -3668,7 +4953,12 @@ void reshade::runtime::update_effects()
 	if (_frame_count == 0 && !_no_reload_on_init)
 		reload_effects();
 
-	if (!is_loading() && !_is_in_preset_transition && !_reload_required_effects.empty())
+	// Switch to the variants compiled for the new preset in the background as soon as all of them are available (see 'load_current_preset')
+	// A single effect may have been reloaded from the code editor in the meantime, so wait for that to finish first
+	if (!_precompile_effect_indices.empty() && _precompile_remaining_effects == 0 && !is_loading())
+		reload_effects(std::exchange(_precompile_effect_indices, {}));
+
+	if (!is_loading() && _precompile_effect_indices.empty() && !_is_in_preset_transition && !_reload_required_effects.empty())
 	{
 		_reload_remaining_effects = 0;
 
@@ -3724,6 +5014,11 @@ void reshade::runtime::update_effects()
 				thread.join(); // Threads have exited, but still need to join them prior to destruction
 		_worker_threads.clear();
 
+		_effect_include_cache.reset();
+
+		// All effects, textures and techniques are in place now, so index them for lookups through the API
+		update_effect_lookup_indices();
+
 		// Finished loading effects, so apply preset to figure out which ones need compiling
 		load_current_preset();
 
@@ -3758,50 +5053,89 @@ void reshade::runtime::update_effects()
 		return;
 	}
 
-	if (_reload_remaining_effects != std::numeric_limits<size_t>::max() || _reload_create_queue.empty())
+	// Write back pipelines that were created the first time a technique was rendered, since the write-back at the end of a reload does not include those
+	if (_pipeline_cache_dirty && !is_loading())
+		save_pipeline_cache();
+
+	// Destroy retired effects that were replaced already, once the GPU finished the last frame they may have been rendered in (but not while loading threads may access the effect lists)
+	if (_retired_effects_last_frame != std::numeric_limits<uint64_t>::max() && !is_loading() &&
+		(_frame_fence == 0 || _device->get_completed_fence_value(_frame_fence) > _retired_effects_last_frame))
+	{
+		destroy_retired_effects();
+
+		// Destroying the retired effects cleared the lookup indices, so rebuild them for the current effects
+		update_effect_lookup_indices();
+	}
+
+	if (_reload_remaining_effects != std::numeric_limits<size_t>::max() || (_reload_create_queue.empty() && (_retired_effects.empty() || _retired_effects_last_frame != std::numeric_limits<uint64_t>::max())))
 		return;
 
-	// Pop an effect from the queue
-	const auto [effect_index, permutation_index] = _reload_create_queue.back();
-	_reload_create_queue.pop_back();
-	effect &effect = _effects[effect_index];
+	const std::chrono::high_resolution_clock::time_point time_create_started = std::chrono::high_resolution_clock::now();
 
-	if (!create_effect(effect_index, permutation_index))
+	// Create as many effects as fit into the time budget of this frame (but at least one), to spread the creation work across frames
+	while (!_reload_create_queue.empty())
 	{
-		_graphics_queue->wait_idle();
-
-		// Destroy all textures belonging to this effect
-		for (texture &tex : _textures)
-			if (tex.shared.size() == 1 && tex.shared[0] == effect_index)
-				destroy_texture(tex);
-		// Disable all techniques belonging to this effect
-		for (technique &tech : _techniques)
-			if (tech.effect_index == effect_index)
-				disable_technique(tech);
+		// Pop an effect from the queue
+		const auto [effect_index, permutation_index] = _reload_create_queue.back();
+		_reload_create_queue.pop_back();
+		effect &effect = _effects[effect_index];
 
-		effect.compiled = false;
-		_last_reload_successful = false;
-	}
+		if (!create_effect(effect_index, permutation_index))
+		{
+			_graphics_queue->wait_idle();
+
+			// Destroy all textures belonging to this effect
+			for (texture &tex : _textures)
+				if (tex.shared.size() == 1 && tex.shared[0] == effect_index)
+					destroy_texture(tex);
+			// Disable all techniques belonging to this effect
+			for (technique &tech : _techniques)
+				if (tech.effect_index == effect_index)
+					disable_technique(tech);
+
+			effect.compiled = false;
+			_last_reload_successful = false;
+		}
 
 #if RESHADE_GUI
-	// Update assembly in all code editors after a reload
-	for (editor_instance &instance : _editors)
-	{
-		if (!instance.generated || instance.entry_point_name.empty() || instance.permutation_index != permutation_index || instance.file_path != effect.source_file)
-			continue;
+		// Update assembly in all code editors after a reload
+		for (editor_instance &instance : _editors)
+		{
+			if (!instance.generated || instance.entry_point_name.empty() || instance.permutation_index != permutation_index || instance.file_path != effect.source_file)
+				continue;
 
-		assert(instance.effect_index == effect_index);
+			assert(instance.effect_index == effect_index);
 
-		const effect::permutation &permutation = effect.permutations[permutation_index];
+			const effect::permutation &permutation = effect.permutations[permutation_index];
 
-		if (permutation.assembly.find(instance.entry_point_name) != permutation.assembly.end())
-			open_code_editor(instance);
-	}
+			if (permutation.assembly.find(instance.entry_point_name) != permutation.assembly.end())
+				open_code_editor(instance);
+		}
 #endif
 
+		if (std::chrono::high_resolution_clock::now() - time_create_started >= std::chrono::milliseconds(_effect_creation_budget))
+			break;
+	}
+
+	if (!_reload_create_queue.empty())
+		return;
+
+	// All new effects were created, so switch over from the retired ones at this frame boundary
+	// These are not destroyed right away, since that would have to wait for the GPU to finish all frames that may still be rendering them
+	if (!_retired_effects.empty())
+	{
+		_retired_effects_last_frame = _frame_count;
+
+		// Make sure the fence is signaled for this frame, even if nothing else is rendered in it
+		if (_frame_fence != 0)
+			_frame_fence_pending_value = _frame_count + 1;
+	}
+
+	// Write back the driver pipeline cache once all effects were created
+	save_pipeline_cache();
+
 #if RESHADE_ADDON
-	if (_reload_create_queue.empty())
-		invoke_addon_event<addon_event::reshade_reloaded_effects>(this);
+	invoke_addon_event<addon_event::reshade_reloaded_effects>(this);
 #endif
 }
 void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource_view rtv, api::resource_view rtv_srgb)
@@ -3811,8 +5145,31 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 		return;
 	_effects_rendered_this_frame = true;
 
-	// Nothing to do here if effects are still loading or disabled globally
-	if (is_loading() || _techniques.empty())
+	if (is_loading())
+	{
+		// Keep rendering the retired effects while new ones are loaded in the background (see 'retire_effects')
+		if (_retired_techniques.empty())
+			return;
+
+		// Loading threads only access the effect lists while holding the reload mutex, so block them until the lists are swapped back
+		const std::unique_lock<std::shared_mutex> lock(_reload_mutex);
+
+		swap_retired_effects();
+		_is_rendering_retired_effects = true;
+
+		update_and_render_effects(cmd_list, rtv, rtv_srgb);
+
+		_is_rendering_retired_effects = false;
+		swap_retired_effects();
+		return;
+	}
+
+	update_and_render_effects(cmd_list, rtv, rtv_srgb);
+}
+void reshade::runtime::update_and_render_effects(api::command_list *cmd_list, api::resource_view rtv, api::resource_view rtv_srgb)
+{
+	// Nothing to do here if there are no effects or they are disabled globally
+	if (_techniques.empty())
 		return;
 	if (!_effects_enabled && std::all_of(_effects.cbegin(), _effects.cend(), [](const effect &effect) { return !effect.addon; }))
 		return;
@@ -4029,6 +5386,9 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 	cmd_list->begin_debug_event("ReShade effects");
 #endif
 
+	// The application rendered a new frame, so the back buffer has to be copied again before it is sampled
+	_effect_permutations[permutation_index].color_tex_up_to_date = false;
+
 	// Render all enabled techniques
 	for (size_t technique_index : _technique_sorting)
 	{
@@ -4042,7 +5402,9 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 		if (permutation_index >= tech.permutations.size() ||
 			(!tech.permutations[permutation_index].created && _effects[effect_index].permutations[permutation_index].cso.empty()))
 		{
-			if (std::find(_reload_required_effects.begin(), _reload_required_effects.end(), std::make_pair(effect_index, permutation_index)) == _reload_required_effects.end())
+			// Retired effects are never reloaded, they are about to be replaced anyway
+			if (!_is_rendering_retired_effects &&
+				std::find(_reload_required_effects.begin(), _reload_required_effects.end(), std::make_pair(effect_index, permutation_index)) == _reload_required_effects.end())
 				_reload_required_effects.emplace_back(effect_index, permutation_index);
 			continue;
 		}
@@ -4070,48 +5432,100 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 }
 void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_list, api::resource back_buffer_resource, api::resource_view back_buffer_rtv, api::resource_view back_buffer_rtv_srgb, size_t permutation_index)
 {
-	const effect &effect = _effects[tech.effect_index];
+	// Pipelines are created the first time a technique is rendered, if that did not happen when creating the effect already
+	if (!tech.permutations[permutation_index].pipelines_created)
+	{
+		if (!create_technique_pipelines(tech, permutation_index))
+		{
+			// Do not try again every frame
+			disable_technique(tech);
+			return;
+		}
+
+		_pipeline_cache_dirty = true;
+	}
+
+	effect &effect = _effects[tech.effect_index];
 	const effect::permutation &permutation = effect.permutations[permutation_index];
 
 #ifndef NDEBUG
 	cmd_list->begin_debug_event(tech.name.c_str());
 #endif
 
-#if RESHADE_GUI
 	uint32_t query_base_index = 0;
-	const bool gather_gpu_statistics = _gather_gpu_statistics && _timestamp_frequency != 0 && effect.query_heap != 0 && permutation_index == 0;
+	bool gather_gpu_statistics = (_gather_gpu_statistics || _statistics_enabled) && _timestamp_query_heap != 0 && permutation_index == 0 && !_is_rendering_retired_effects &&
+		// Only the immediate command list is submitted before the frame fence is signaled at the start of the next frame
+		cmd_list == _graphics_queue->get_immediate_command_list();
 
 	if (gather_gpu_statistics)
 	{
+		timestamp_frame &frame = _timestamp_frames[_timestamp_frame_index];
+
 		const uint32_t query_count = static_cast<uint32_t>((1 + tech.permutations[0].passes.size()) * 2);
-		query_base_index = tech.query_base_index + (_frame_count % 4) * query_count;
 
-		// Evaluate queries from oldest frame in queue
-		if (temp_mem<uint64_t> timestamps(query_count);
-			_device->get_query_heap_results(effect.query_heap, api::query_type::timestamp, query_base_index, query_count, timestamps.p, sizeof(uint64_t)))
+		// Skip measurement if the queries of this frame are still in flight or there is no space left for more
+		if (frame.fence_value == 0 && frame.query_count + query_count <= _timestamp_queries_per_frame)
 		{
-			const uint64_t tech_duration = timestamps[1] - timestamps[0];
-			tech.average_gpu_duration.append(tech_duration * 1'000'000'000ull / _timestamp_frequency);
+			query_base_index = static_cast<uint32_t>(_timestamp_frame_index) * _timestamp_queries_per_frame + frame.query_count;
 
-			for (size_t pass_index = 0; pass_index < tech.permutations[0].passes.size(); ++pass_index)
-			{
-				const uint64_t pass_duration = timestamps[2 + pass_index * 2 + 1] - timestamps[2 + pass_index * 2];
-				tech.permutations[0].passes[pass_index].average_gpu_duration.append(pass_duration * 1'000'000'000ull / _timestamp_frequency);
-			}
-		}
+			frame.query_count += query_count;
+			frame.techniques.emplace_back(static_cast<size_t>(&tech - _techniques.data()), query_base_index);
 
-		cmd_list->end_query(effect.query_heap, api::query_type::timestamp, query_base_index);
+			cmd_list->end_query(_timestamp_query_heap, api::query_type::timestamp, query_base_index);
+		}
+		else
+		{
+			gather_gpu_statistics = false;
+		}
 	}
 
 	const std::chrono::high_resolution_clock::time_point time_technique_started = std::chrono::high_resolution_clock::now();
-#endif
 
-	// Update shader constants
-	if (void *mapped_uniform_data;
-		effect.cb != 0 && _device->map_buffer_region(effect.cb, 0, effect.uniform_data_storage.size(), api::map_access::write_discard, &mapped_uniform_data))
+	// The GPU progress of this frame has to be tracked for constant buffer slices and timestamp queries
+	if (_frame_fence != 0)
+		_frame_fence_pending_value = _frame_count + 1;
+
+	// Update shader constants, but only if they were modified since the last upload (so not again for every technique of the same effect)
+	if (effect.cb != 0)
 	{
-		std::memcpy(mapped_uniform_data, effect.uniform_data_storage.data(), effect.uniform_data_storage.size());
-		_device->unmap_buffer_region(effect.cb);
+		const uint32_t frame_set_index = static_cast<uint32_t>(_frame_count % effect.cb_frames_in_flight);
+
+		// Slices of other frames are overwritten when those frame sets are reused, so the data of a slice still bound from another frame has to be uploaded into the set of the current frame as well
+		if (effect.uniform_data_dirty_begin != effect.uniform_data_dirty_end ||
+			(effect.cb_slice_count != 1 && effect.cb_slice_index / effect.cb_slices_per_frame != frame_set_index))
+		{
+			if (effect.cb_slice_frame != _frame_count)
+			{
+				effect.cb_slice_frame = _frame_count;
+				effect.cb_slices_used_in_frame = 0;
+			}
+
+			// Each frame in flight has its own set of slices, so if those were all used up already (e.g. because effects are rendered many times this frame), keep using the last one and upload the changes next frame
+			if (effect.cb_slice_count == 1 || effect.cb_slices_used_in_frame < effect.cb_slices_per_frame)
+			{
+				const uint32_t slice_index = effect.cb_slice_count == 1 ? 0 : frame_set_index * effect.cb_slices_per_frame + effect.cb_slices_used_in_frame;
+
+				// The set of this frame was last used a number of frames ago, so the GPU should be done with it already, unless more frames than there are sets are in flight
+				if (const uint64_t set_frame = effect.cb_set_frame[frame_set_index];
+					effect.cb_slice_count != 1 && _frame_fence != 0 && set_frame < _frame_count && _device->get_completed_fence_value(_frame_fence) <= set_frame)
+					_device->wait(_frame_fence, set_frame + 1);
+
+				// A different slice does not contain the previous data, so the entire buffer has to be written
+				if (void *mapped_uniform_data;
+					_device->map_buffer_region(effect.cb, slice_index * effect.cb_slice_size, effect.uniform_data_storage.size(), effect.cb_slice_count == 1 ? api::map_access::write_discard : api::map_access::write_only, &mapped_uniform_data))
+				{
+					std::memcpy(mapped_uniform_data, effect.uniform_data_storage.data(), effect.uniform_data_storage.size());
+					_device->unmap_buffer_region(effect.cb);
+
+					effect.cb_slice_index = slice_index;
+					effect.cb_slices_used_in_frame++;
+					effect.uniform_data_dirty_begin = effect.uniform_data_dirty_end = 0;
+				}
+			}
+		}
+
+		if (effect.cb_slice_count != 1)
+			effect.cb_set_frame[effect.cb_slice_index / effect.cb_slices_per_frame] = _frame_count;
 	}
 	else if (_device->get_api() == api::device_api::d3d9)
 	{
@@ -4121,11 +5535,14 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 	const bool sampler_with_resource_view = _device->check_capability(api::device_caps::sampler_with_resource_view);
 
 	bool is_effect_stencil_cleared = false;
-	bool needs_implicit_back_buffer_copy = true; // First pass always needs the back buffer updated
+	// Whether the effect color texture still matches the back buffer is tracked across techniques, so that the copy is only done when a pass actually samples a modified back buffer
+	bool &color_tex_up_to_date = _effect_permutations[permutation_index].color_tex_up_to_date;
 
 	for (size_t pass_index = 0; pass_index < tech.permutations[permutation_index].passes.size(); ++pass_index)
 	{
-		if (needs_implicit_back_buffer_copy)
+		const technique::pass &pass = tech.permutations[permutation_index].passes[pass_index];
+
+		if (pass.samples_back_buffer && !color_tex_up_to_date)
 		{
 			// Save back buffer of previous pass
 			const api::resource resources[2] = { back_buffer_resource, _effect_permutations[permutation_index].color_tex};
@@ -4135,26 +5552,22 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 			cmd_list->barrier(2, resources, state_old, state_new);
 			cmd_list->copy_texture_region(back_buffer_resource, 0, nullptr, _effect_permutations[permutation_index].color_tex, 0, nullptr);
 			cmd_list->barrier(2, resources, state_new, state_old);
-		}
 
-		const technique::pass &pass = tech.permutations[permutation_index].passes[pass_index];
+			color_tex_up_to_date = true;
+		}
 
 #ifndef NDEBUG
 		cmd_list->begin_debug_event((pass.name.empty() ? "Pass " + std::to_string(pass_index) : pass.name).c_str());
 #endif
 
-#if RESHADE_GUI
 		if (gather_gpu_statistics)
-			cmd_list->end_query(effect.query_heap, api::query_type::timestamp, query_base_index + static_cast<uint32_t>((1 + pass_index) * 2));
-#endif
+			cmd_list->end_query(_timestamp_query_heap, api::query_type::timestamp, query_base_index + static_cast<uint32_t>((1 + pass_index) * 2));
 
 		const uint32_t num_barriers = static_cast<uint32_t>(pass.modified_resources.size());
 
 		if (!pass.cs_entry_point.empty())
 		{
 			// Compute shaders do not write to the back buffer, so no update necessary
-			needs_implicit_back_buffer_copy = false;
-
 			cmd_list->bind_pipeline(api::pipeline_stage::all_compute, pass.pipeline);
 
 			temp_mem<api::resource_usage> state_old, state_new;
@@ -4164,7 +5577,7 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			// Reset bindings on every pass (since they get invalidated by the call to 'generate_mipmaps' below)
 			if (effect.cb != 0)
-				cmd_list->bind_descriptor_table(api::shader_stage::all_compute, permutation.layout, 0, permutation.cb_table);
+				cmd_list->bind_descriptor_table(api::shader_stage::all_compute, permutation.layout, 0, permutation.cb_tables[effect.cb_slice_index]);
 			if (permutation.sampler_table != 0)
 				assert(!sampler_with_resource_view),
 				cmd_list->bind_descriptor_table(api::shader_stage::all_compute, permutation.layout, 1, permutation.sampler_table);
@@ -4181,11 +5594,19 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 		{
 			cmd_list->bind_pipeline(api::pipeline_stage::all_graphics, pass.pipeline);
 
-			// Transition resource state for render targets
+			// Transition resource state for render targets (unless the previous pass left them in that state already)
 			temp_mem<api::resource_usage> state_old, state_new;
 			std::fill_n(state_old.p, num_barriers, api::resource_usage::shader_resource);
 			std::fill_n(state_new.p, num_barriers, api::resource_usage::render_target);
-			cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_old.p, state_new.p);
+			if (!pass.skip_barriers_before)
+			{
+				cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_old.p, state_new.p);
+			}
+			else if (_device->get_api() == api::device_api::vulkan)
+			{
+				// Render target writes of the previous pass still have to be made visible to this pass in Vulkan, so only the round trip through the shader resource state is skipped
+				cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_new.p, state_new.p);
+			}
 
 			// Setup render targets
 			uint32_t render_target_count = 0;
@@ -4194,15 +5615,13 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			if (pass.render_target_names[0].empty())
 			{
-				needs_implicit_back_buffer_copy = true;
+				color_tex_up_to_date = false;
 
 				render_target[0].view = pass.srgb_write_enable ? back_buffer_rtv_srgb : back_buffer_rtv;
 				render_target_count = 1;
 			}
 			else
 			{
-				needs_implicit_back_buffer_copy = false;
-
 				for (int i = 0; i < 8 && pass.render_target_views[i] != 0; ++i, ++render_target_count)
 					render_target[i].view = pass.render_target_views[i];
 			}
@@ -4228,7 +5647,7 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			// Reset bindings on every pass (since they get invalidated by the call to 'generate_mipmaps' below)
 			if (effect.cb != 0)
-				cmd_list->bind_descriptor_table(api::shader_stage::all_graphics, permutation.layout, 0, permutation.cb_table);
+				cmd_list->bind_descriptor_table(api::shader_stage::all_graphics, permutation.layout, 0, permutation.cb_tables[effect.cb_slice_index]);
 			if (permutation.sampler_table != 0)
 				assert(!sampler_with_resource_view),
 				cmd_list->bind_descriptor_table(api::shader_stage::all_graphics, permutation.layout, 1, permutation.sampler_table);
@@ -4294,14 +5713,13 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			cmd_list->end_render_pass();
 
-			// Transition resource state back to shader access
-			cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_new.p, state_old.p);
+			// Transition resource state back to shader access (unless the next pass writes to the same render targets again)
+			if (!pass.skip_barriers_after)
+				cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_new.p, state_old.p);
 		}
 
-#if RESHADE_GUI
 		if (gather_gpu_statistics)
-			cmd_list->end_query(effect.query_heap, api::query_type::timestamp, query_base_index + static_cast<uint32_t>((1 + pass_index) * 2) + 1);
-#endif
+			cmd_list->end_query(_timestamp_query_heap, api::query_type::timestamp, query_base_index + static_cast<uint32_t>((1 + pass_index) * 2) + 1);
 
 #ifndef NDEBUG
 		cmd_list->end_debug_event();
@@ -4312,20 +5730,28 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 			cmd_list->generate_mipmaps(modified_texture);
 	}
 
-#if RESHADE_GUI
 	const std::chrono::high_resolution_clock::time_point time_technique_finished = std::chrono::high_resolution_clock::now();
 
 	tech.average_cpu_duration.append(std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count());
 
+	if (_statistics_trace_file != nullptr)
+		write_statistics_trace_event(
+			tech.name + '@' + effect.source_file.filename().u8string(), "technique", 0,
+			std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_started - _start_time).count(),
+			std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count());
+
 	if (gather_gpu_statistics)
-		cmd_list->end_query(effect.query_heap, api::query_type::timestamp, query_base_index + 1);
-#endif
+		cmd_list->end_query(_timestamp_query_heap, api::query_type::timestamp, query_base_index + 1);
 
 #ifndef NDEBUG
 	cmd_list->end_debug_event();
 #endif
 
 #if RESHADE_ADDON
+	// Add-ons may modify the back buffer in this event, so cannot rely on the effect color texture being up-to-date afterwards
+	if (has_addon_event<addon_event::reshade_render_technique>())
+		color_tex_up_to_date = false;
+
 	invoke_addon_event<addon_event::reshade_render_technique>(const_cast<runtime *>(this), api::effect_technique { reinterpret_cast<uintptr_t>(&tech) }, cmd_list, back_buffer_rtv, back_buffer_rtv_srgb);
 #endif
 }
@@ -4550,6 +5976,7 @@ void reshade::runtime::reset_uniform_value(uniform &variable)
 	if (variable.special != reshade::special_uniform::none)
 	{
 		std::memset(_effects[variable.effect_index].uniform_data_storage.data() + variable.offset, 0, variable.size);
+		_effects[variable.effect_index].mark_uniform_data_dirty(variable.offset, variable.size);
 		return;
 	}
 
@@ -4678,28 +6105,38 @@ template <> void reshade::runtime::get_uniform_value<uint32_t>(const uniform &va
 void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *data, size_t size, size_t base_index)
 {
 #if RESHADE_ADDON
-	if (!is_loading() && invoke_addon_event<addon_event::reshade_set_uniform_value>(this, api::effect_uniform_variable { reinterpret_cast<uintptr_t>(&variable) }, data, size))
+	// Batched updates already triggered a single event for all variables in 'set_uniform_values'
+	if (!is_loading() && !_is_in_batched_uniform_update && invoke_addon_event<addon_event::reshade_set_uniform_value>(this, api::effect_uniform_variable { reinterpret_cast<uintptr_t>(&variable) }, data, size))
 		return;
 #endif
 
 	size = std::min(size, static_cast<size_t>(variable.size));
 	assert(data != nullptr && (size % 4) == 0);
 
-	std::vector<uint8_t> &data_storage = _effects[variable.effect_index].uniform_data_storage;
+	effect &effect = _effects[variable.effect_index];
+	std::vector<uint8_t> &data_storage = effect.uniform_data_storage;
 	assert(variable.offset + size <= data_storage.size());
 
 	const size_t array_length = (variable.type.is_array() ? variable.type.array_length : 1u);
 	if (assert(base_index < array_length); base_index >= array_length)
 		return;
 
+	// Only mark data that actually changed as dirty, so that setting the same value every frame does not cause the constant buffer to be uploaded again
+	const auto write = [&effect, &data_storage](size_t offset, const uint8_t *value, size_t value_size) {
+		if (std::memcmp(data_storage.data() + offset, value, value_size) == 0)
+			return;
+		std::memcpy(data_storage.data() + offset, value, value_size);
+		effect.mark_uniform_data_dirty(offset, value_size);
+	};
+
 	if (variable.type.is_matrix())
 	{
 		for (size_t a = base_index, i = 0; a < array_length; ++a)
 			// Each row of a matrix is 16-byte aligned, so needs special handling
 			for (size_t row = 0; row < variable.type.rows; ++row)
 				for (size_t col = 0; i < (size / 4) && col < variable.type.cols; ++col, ++i)
-					std::memcpy(
-						data_storage.data() + variable.offset + (a * variable.type.rows * 4 + (row * 4 + col)) * 4,
+					write(
+						variable.offset + (a * variable.type.rows * 4 + (row * 4 + col)) * 4,
 						data + ((a - base_index) * variable.type.components() + (row * variable.type.cols + col)) * 4, 4);
 	}
 	else if (array_length > 1)
@@ -4707,13 +6144,13 @@ void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *
 		for (size_t a = base_index, i = 0; a < array_length; ++a)
 			// Each element in the array is 16-byte aligned, so needs special handling
 			for (size_t row = 0; i < (size / 4) && row < variable.type.rows; ++row, ++i)
-				std::memcpy(
-					data_storage.data() + variable.offset + (a * 4 + row) * 4,
+				write(
+					variable.offset + (a * 4 + row) * 4,
 					data + ((a - base_index) * variable.type.components() + row) * 4, 4);
 	}
 	else
 	{
-		std::memcpy(data_storage.data() + variable.offset, data, size);
+		write(variable.offset, data, size);
 	}
 }
 
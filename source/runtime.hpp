@@ -7,14 +7,25 @@
 
 #include "reshade_api.hpp"
 #include "state_block.hpp"
+#include "moving_average.hpp"
 #include "imgui_code_editor.hpp"
+#include <cstdio>
 #include <atomic>
 #include <thread>
 #include <chrono>
 #include <memory>
 #include <filesystem>
+#include <future>
 #include <mutex>
 #include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace reshadefx
+{
+	class codegen;
+	class include_cache;
+}
 
 namespace reshade
 {
@@ -22,6 +33,64 @@ namespace reshade
 	struct uniform;
 	struct texture;
 	struct technique;
+	struct effect_variant;
+	struct texture_source;
+
+	/// <summary>
+	/// Hash index from effect file names and object names to handles of those objects, so that they can be looked up without scanning through all of them.
+	/// This only references the names, so it has to be rebuilt whenever the objects are modified.
+	/// </summary>
+	class effect_lookup_index
+	{
+	public:
+		void clear() { _entries.clear(); }
+
+		/// <summary>
+		/// Adds an object to the index, unless there already is one with the same names (so that the first one added takes precedence).
+		/// </summary>
+		/// <param name="effect_name">File name of the effect the object belongs to, or an empty string to make it available to lookups in all effects.</param>
+		/// <param name="name">Name of the object.</param>
+		/// <param name="handle">Handle to the object.</param>
+		void insert(std::string_view effect_name, std::string_view name, uintptr_t handle)
+		{
+			if (find(effect_name, name) != 0)
+				return;
+
+			_entries.emplace(hash(effect_name, name), entry { effect_name, name, handle });
+		}
+
+		/// <summary>
+		/// Finds the handle to the object with the specified names.
+		/// </summary>
+		/// <param name="effect_name">File name of the effect the object belongs to, or an empty string to search in all effects.</param>
+		/// <param name="name">Name of the object.</param>
+		/// <returns>Handle to the object, or zero in case it was not found.</returns>
+		uintptr_t find(std::string_view effect_name, std::string_view name) const
+		{
+			for (auto [it, end] = _entries.equal_range(hash(effect_name, name)); it != end; ++it)
+				if (it->second.effect_name == effect_name && it->second.name == name)
+					return it->second.handle;
+			return 0;
+		}
+
+	private:
+		struct entry
+		{
+			std::string_view effect_name;
+			std::string_view name;
+			uintptr_t handle;
+		};
+
+		static size_t hash(std::string_view effect_name, std::string_view name)
+		{
+			size_t hash = std::hash<std::string_view>()(name);
+			if (!effect_name.empty())
+				hash ^= std::hash<std::string_view>()(effect_name) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			return hash;
+		}
+
+		std::unordered_multimap<size_t, entry> _entries;
+	};
 
 	/// <summary>
 	/// The main ReShade post-processing effect runtime.
@@ -89,6 +158,7 @@ namespace reshade
 		void enumerate_uniform_variables(const char *effect_name, void(*callback)(effect_runtime *runtime, api::effect_uniform_variable variable, void *user_data), void *user_data) final;
 
 		api::effect_uniform_variable find_uniform_variable(const char *effect_name, const char *variable_name) const final;
+		void find_uniform_variables(const char *effect_name, size_t count, const char *const *variable_names, api::effect_uniform_variable *out_variables) const final;
 
 		void get_uniform_variable_type(api::effect_uniform_variable variable, api::format *out_base_type, uint32_t *out_rows, uint32_t *out_columns, uint32_t *out_array_length) const final;
 
@@ -112,10 +182,12 @@ namespace reshade
 		void set_uniform_value_float(api::effect_uniform_variable variable, const float *values, size_t count, size_t array_index) final;
 		void set_uniform_value_int(api::effect_uniform_variable variable, const int32_t *values, size_t count, size_t array_index) final;
 		void set_uniform_value_uint(api::effect_uniform_variable variable, const uint32_t *values, size_t count, size_t array_index) final;
+		void set_uniform_values(size_t count, const api::effect_uniform_value_update *updates) final;
 
 		void enumerate_texture_variables(const char *effect_name, void(*callback)(effect_runtime *runtime, api::effect_texture_variable variable, void *user_data), void *user_data) final;
 
 		api::effect_texture_variable find_texture_variable(const char *effect_name, const char *variable_name) const final;
+		void find_texture_variables(const char *effect_name, size_t count, const char *const *variable_names, api::effect_texture_variable *out_variables) const final;
 
 		void get_texture_variable_name(api::effect_texture_variable variable, char *name, size_t *name_size) const final;
 		void get_texture_variable_effect_name(api::effect_texture_variable variable, char *effect_name, size_t *effect_name_size) const final;
@@ -135,6 +207,7 @@ namespace reshade
 		void enumerate_techniques(const char *effect_name, void(*callback)(effect_runtime *runtime, api::effect_technique technique, void *user_data), void *user_data) final;
 
 		api::effect_technique find_technique(const char *effect_name, const char *technique_name) final;
+		void find_techniques(const char *effect_name, size_t count, const char *const *technique_names, api::effect_technique *out_techniques) final;
 
 		void get_technique_name(api::effect_technique technique, char *name, size_t *name_size) const final;
 		void get_technique_effect_name(api::effect_technique technique, char *effect_name, size_t *effect_name_size) const final;
@@ -170,6 +243,13 @@ namespace reshade
 
 		void reload_effect_next_frame(const char *effect_name) final;
 
+		bool get_statistics_state() const final { return _statistics_enabled; }
+		void set_statistics_state(bool enabled) final;
+
+		bool get_technique_statistics(api::effect_technique technique, api::effect_statistics *out_cpu_time, api::effect_statistics *out_gpu_time) const final;
+		bool get_technique_pass_statistics(api::effect_technique technique, size_t pass_index, api::effect_statistics *out_gpu_time) const final;
+		bool get_addon_statistics(const char *addon_name, api::effect_statistics *out_cpu_time) const final;
+
 		void load_config();
 		void save_config() const;
 
@@ -181,11 +261,14 @@ namespace reshade
 
 		bool switch_to_next_preset(std::filesystem::path filter_path, bool reversed = false);
 
-		bool load_effect(const std::filesystem::path &source_file, const class ini_file &preset, size_t effect_index, size_t permutation_index, bool force_load = false, bool preprocess_required = false);
+		reshadefx::codegen *create_effect_codegen(bool debug_info) const;
+		bool load_effect(const std::filesystem::path &source_file, const class ini_file &preset, size_t effect_index, size_t permutation_index, bool force_load = false, bool preprocess_required = false, bool variant_only = false);
 		bool create_effect(size_t effect_index, size_t permutation_index);
+		bool create_technique_pipelines(technique &tech, size_t permutation_index);
 		void destroy_effect(size_t effect_index, bool unload = true);
 
 		void load_textures(size_t effect_index);
+		std::shared_ptr<const texture_source> load_texture_source(const texture &texture, const std::filesystem::path &source_path, std::string &errors);
 		bool create_texture(texture &texture);
 		void destroy_texture(texture &texture);
 
@@ -197,15 +280,24 @@ namespace reshade
 		void load_effects(bool force_load_all = false);
 		bool reload_effect(size_t effect_index);
 		void reload_effects(bool force_load_all = false);
+		void reload_effects(const std::vector<size_t> &effect_indices);
+		void precompile_effect_variants(const std::vector<size_t> &effect_indices);
 		void destroy_effects();
+		void retire_effects();
+		void destroy_retired_effects();
+		void swap_retired_effects();
+
+		void update_effect_lookup_indices();
 
 		bool load_effect_cache(const std::string &id, const std::string &type, std::string &data) const;
 		bool save_effect_cache(const std::string &id, const std::string &type, const std::string &data) const;
+		void save_pipeline_cache();
 		void clear_effect_cache();
 
 		auto add_effect_permutation(uint32_t width, uint32_t height, api::format color_format, api::format stencil_format, api::color_space color_space) -> size_t;
 
 		void update_effects();
+		void update_and_render_effects(api::command_list *cmd_list, api::resource_view rtv, api::resource_view rtv_srgb);
 		void render_technique(technique &technique, api::command_list *cmd_list, api::resource back_buffer_resource, api::resource_view back_buffer_rtv, api::resource_view back_buffer_rtv_srgb, size_t permutation_index);
 
 		void save_texture(const texture &texture);
@@ -236,6 +328,12 @@ namespace reshade
 
 		bool execute_screenshot_post_save_command(const std::filesystem::path &screenshot_path, unsigned int screenshot_count, std::string_view postfix);
 
+		void update_statistics();
+		void read_timestamp_queries();
+		void submit_timestamp_queries(api::command_list *cmd_list);
+		void destroy_timestamp_queries();
+		void write_statistics_trace_event(const std::string &name, const char *category, uint32_t thread_id, uint64_t start_time, uint64_t duration);
+
 		api::swapchain *const _swapchain;
 		api::device *const _device;
 		api::command_queue *const _graphics_queue;
@@ -251,6 +349,7 @@ namespace reshade
 
 #if RESHADE_ADDON
 		bool _is_in_present_call = false;
+		bool _is_in_batched_uniform_update = false;
 #endif
 
 		#pragma region Status
@@ -273,6 +372,9 @@ namespace reshade
 
 		std::chrono::system_clock::time_point _current_time;
 		uint64_t _frame_count = 0;
+		// Fence that is signaled with the frame count plus one after the work of that frame was submitted, or zero if fences are not supported
+		api::fence _frame_fence = {};
+		uint64_t _frame_fence_pending_value = 0;
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
 		std::chrono::high_resolution_clock::time_point _start_time, _last_present_time;
 		#pragma endregion
@@ -283,6 +385,10 @@ namespace reshade
 		bool _no_reload_on_init = false;
 		bool _performance_mode = false;
 		bool _effect_load_skipping = false;
+		unsigned int _effect_variant_cache_size = 32;
+		unsigned int _texture_source_cache_size = 256; // In MiB
+		bool _effect_background_reload = true;
+		unsigned int _effect_creation_budget = 2; // In milliseconds
 		unsigned int _reload_key_data[4] = {};
 
 		std::vector<std::pair<std::string, std::string>> _global_preprocessor_definitions;
@@ -297,14 +403,65 @@ namespace reshade
 		std::shared_mutex _reload_mutex;
 		std::vector<std::pair<size_t, size_t>> _reload_create_queue;
 		std::atomic<size_t> _reload_remaining_effects = std::numeric_limits<size_t>::max();
+		// Effects that are reloaded for a new preset once their variants finished compiling in the background (see 'precompile_effect_variants')
+		std::vector<size_t> _precompile_effect_indices;
+		std::atomic<size_t> _precompile_remaining_effects = 0;
+		// Preprocessed include files shared by all effects loaded together in 'load_effects', so that common headers are only preprocessed once
+		std::unique_ptr<reshadefx::include_cache> _effect_include_cache;
+		bool _effect_pipeline_cache_loaded = false;
+		std::thread _pipeline_cache_save_thread;
+		bool _pipeline_cache_dirty = false;
+
+		// File names of all effects and indexes from those and object names to handles, which are used by the 'find_*' functions instead of scanning all objects
+		std::vector<std::string> _effect_lookup_names;
+		effect_lookup_index _uniform_lookup_index;
+		effect_lookup_index _texture_lookup_index;
+		effect_lookup_index _technique_lookup_index;
+
+		/// <summary>
+		/// Texture resource shared by transient textures (see <see cref="texture::transient_technique"/>) with the same description.
+		/// Those are only ever live while their technique is rendering, so textures used by different techniques can alias the same memory.
+		/// </summary>
+		struct transient_texture_allocation
+		{
+			struct user
+			{
+				std::string texture_name;
+				size_t effect_index;
+				std::string technique_name;
+			};
+
+			api::resource resource = {};
+			api::resource_desc desc;
+			std::vector<user> users;
+		};
 
 		std::vector<effect> _effects;
 		std::vector<texture> _textures;
+		std::vector<transient_texture_allocation> _transient_textures;
 		std::vector<technique> _techniques;
 		std::vector<size_t> _technique_sorting;
 
+		// Previous effects, which keep rendering while new ones are loaded in the background after a reload (see 'retire_effects')
+		std::vector<effect> _retired_effects;
+		std::vector<texture> _retired_textures;
+		std::vector<transient_texture_allocation> _retired_transient_textures;
+		std::vector<technique> _retired_techniques;
+		std::vector<size_t> _retired_technique_sorting;
+		bool _is_rendering_retired_effects = false;
+		// Last frame the retired effects may have been rendered in once the new ones took over, after which they are destroyed as soon as the GPU finished it
+		uint64_t _retired_effects_last_frame = std::numeric_limits<uint64_t>::max();
+
 		std::vector<std::thread> _worker_threads;
 		std::chrono::high_resolution_clock::time_point _last_reload_time;
+
+		std::mutex _effect_variant_cache_mutex;
+		// Compiled variants indexed by the source hash of their effect, with multiple entries for the same hash only differing in specialization constant values
+		std::unordered_multimap<size_t, std::unique_ptr<effect_variant>> _effect_variant_cache;
+		uint64_t _effect_variant_cache_use_count = 0;
+
+		std::mutex _texture_source_cache_mutex;
+		std::vector<std::shared_ptr<const texture_source>> _texture_source_cache;
 		#pragma endregion
 
 		#pragma region Effect Rendering
@@ -316,6 +473,7 @@ namespace reshade
 			api::format color_format = api::format::unknown;
 			api::resource color_tex = {};
 			api::resource_view color_srv[2] = {};
+			bool color_tex_up_to_date = false;
 			api::format stencil_format = api::format::unknown;
 			api::resource stencil_tex = {};
 			api::resource_view stencil_dsv = {};
@@ -385,6 +543,40 @@ namespace reshade
 		std::vector<preset_shortcut> _preset_shortcuts;
 		#pragma endregion
 
+		#pragma region Statistics
+		bool _statistics_enabled = false;
+		bool _gather_gpu_statistics = false;
+		uint64_t _timestamp_frequency = 0;
+
+		/// <summary>
+		/// Timestamp queries recorded during a frame, which are only read back once the GPU finished that frame, so that gathering GPU statistics never stalls.
+		/// </summary>
+		struct timestamp_frame
+		{
+			uint64_t frame_count = 0;
+			// Value the timestamp fence has after the GPU finished this frame, or zero if this frame is not in flight
+			uint64_t fence_value = 0;
+			uint32_t query_count = 0;
+			// Index of each technique measured in this frame and the index of its first query
+			std::vector<std::pair<size_t, uint32_t>> techniques;
+		};
+		api::query_heap _timestamp_query_heap = {};
+		api::resource _timestamp_readback_buffer = {};
+		uint32_t _timestamp_queries_per_frame = 0;
+		size_t _timestamp_frame_index = 0;
+		timestamp_frame _timestamp_frames[8];
+		// Number of frames the GPU statistics lag behind the current frame
+		uint64_t _timestamp_latency = 0;
+
+		std::filesystem::path _statistics_trace_path;
+		FILE *_statistics_trace_file = nullptr;
+		uint64_t _statistics_trace_gpu_base_time = 0;
+#if RESHADE_ADDON
+		std::unordered_map<std::string, moving_average<uint64_t, 60>> _addon_cpu_durations;
+		std::unordered_map<std::string, uint64_t> _addon_cpu_duration_totals;
+#endif
+		#pragma endregion
+
 #if RESHADE_GUI
 		void init_gui();
 		bool init_gui_vr();
@@ -490,10 +682,8 @@ namespace reshade
 		#pragma endregion
 
 		#pragma region Overlay Statistics
-		bool _gather_gpu_statistics = false;
 		size_t _preview_texture = std::numeric_limits<size_t>::max();
 		unsigned int _preview_size[3] = { 0, 0, 0xFFFFFFFF };
-		uint64_t _timestamp_frequency = 0;
 		#pragma endregion
 
 		#pragma region Overlay Log
@@ -503,6 +693,22 @@ namespace reshade
 		#pragma endregion
 
 		#pragma region Overlay Code Editor
+		/// <summary>
+		/// Result of a background check of edited effect code (see <see cref="check_effect_source"/>).
+		/// </summary>
+		struct editor_check_result
+		{
+			/// <summary>
+			/// Hash of the preprocessed source code the parser errors below were reported for.
+			/// </summary>
+			size_t source_hash = 0;
+			std::string parser_errors;
+			/// <summary>
+			/// All preprocessor and parser errors of the check.
+			/// </summary>
+			std::string errors;
+		};
+
 		struct editor_instance
 		{
 			size_t effect_index;
@@ -512,6 +718,14 @@ namespace reshade
 			bool selected = false;
 			bool generated = false;
 			imgui::code_editor editor;
+			size_t edit_version = 0;
+			size_t checked_version = 0;
+			std::chrono::high_resolution_clock::time_point edit_time;
+			// State of the background check of the edited code, which is used to update errors while typing
+			std::future<editor_check_result> check_result;
+			size_t check_version = 0;
+			size_t check_source_hash = 0;
+			std::string check_parser_errors;
 		};
 
 		void open_code_editor(size_t effect_index, size_t permutation_index, const std::string &entry_point);
@@ -519,6 +733,12 @@ namespace reshade
 		void open_code_editor(editor_instance &instance) const;
 		void draw_code_editor(editor_instance &instance);
 
+		/// <summary>
+		/// Preprocesses and parses an effect with the text of a file that is being edited, without compiling or creating it, and writes the resulting errors to <paramref name="result"/>.
+		/// Parsing is skipped if the preprocessed source code has the same hash as in the previous result passed in.
+		/// </summary>
+		void check_effect_source(const std::filesystem::path &source_file, const std::vector<std::pair<std::string, std::string>> &macros, const std::vector<std::filesystem::path> &include_paths, const std::filesystem::path &edited_file, std::string edited_source, editor_check_result &result) const;
+
 		std::vector<editor_instance> _editors;
 		uint32_t _editor_palette[imgui::code_editor::color_palette_max];
 		#pragma endregion
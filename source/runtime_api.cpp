@@ -84,30 +84,17 @@ void reshade::runtime::enumerate_uniform_variables(const char *effect_name_in, v
 	}
 }
 
-reshade::api::effect_uniform_variable reshade::runtime::find_uniform_variable(const char *effect_name_in, const char *variable_name_in) const
+reshade::api::effect_uniform_variable reshade::runtime::find_uniform_variable(const char *effect_name, const char *variable_name) const
 {
-	if (is_loading() || variable_name_in == nullptr)
+	if (is_loading() || variable_name == nullptr || (effect_name != nullptr && *effect_name == '\0'))
 		return { 0 };
 
-	const std::filesystem::path effect_name = effect_name_in != nullptr ? std::filesystem::u8path(effect_name_in) : std::filesystem::path();
-	const std::string_view variable_name(variable_name_in);
-
-	for (const effect &effect : _effects)
-	{
-		if (effect_name_in != nullptr && effect.source_file.filename() != effect_name)
-			continue;
-
-		for (const uniform &variable : effect.uniforms)
-		{
-			if (variable.name == variable_name)
-				return { reinterpret_cast<uintptr_t>(&variable) };
-		}
-
-		if (effect_name_in != nullptr)
-			break;
-	}
-
-	return { 0 };
+	return { _uniform_lookup_index.find(effect_name != nullptr ? effect_name : std::string_view(), variable_name) };
+}
+void reshade::runtime::find_uniform_variables(const char *effect_name, size_t count, const char *const *variable_names, api::effect_uniform_variable *out_variables) const
+{
+	for (size_t i = 0; i < count; ++i)
+		out_variables[i] = find_uniform_variable(effect_name, variable_names[i]);
 }
 
 void reshade::runtime::get_uniform_variable_type(api::effect_uniform_variable handle, api::format *out_base_type, uint32_t *out_rows, uint32_t *out_columns, uint32_t *out_array_length) const
@@ -416,34 +403,55 @@ void reshade::runtime::set_uniform_value_uint(api::effect_uniform_variable handl
 
 	set_uniform_value(*variable, values, count, array_index);
 }
-
-void reshade::runtime::enumerate_texture_variables(const char *effect_name_in, void(*callback)(effect_runtime *runtime, api::effect_texture_variable variable, void *user_data), void *user_data)
+void reshade::runtime::set_uniform_values(size_t count, const api::effect_uniform_value_update *updates)
 {
-	if (is_loading())
+	if (count == 0)
 		return;
 
-	const std::filesystem::path effect_name = effect_name_in != nullptr ? std::filesystem::u8path(effect_name_in) : std::filesystem::path();
+#if RESHADE_ADDON
+	if (!is_loading() && invoke_addon_event<addon_event::reshade_set_uniform_values>(this, count, updates))
+		return;
 
-	for (const texture &variable : _textures)
+	_is_in_batched_uniform_update = true;
+#endif
+
+	for (size_t i = 0; i < count; ++i)
 	{
-		if (effect_name_in != nullptr &&
-			std::find_if(variable.shared.cbegin(), variable.shared.cend(),
-				[&](size_t effect_index) {
-					return _effects[effect_index].source_file.filename() == effect_name;
-				}) == variable.shared.cend())
+		const api::effect_uniform_value_update &update = updates[i];
+
+		const auto variable = reinterpret_cast<uniform *>(update.variable.handle);
+		if (variable == nullptr || update.count == 0)
 			continue;
 
-		callback(this, { reinterpret_cast<uintptr_t>(&variable) }, user_data);
+		// Writes to the same effect accumulate into a single dirty range of its uniform data storage, which is uploaded once during rendering
+		switch (update.type)
+		{
+		case api::effect_uniform_value_type::boolean:
+			set_uniform_value(*variable, static_cast<const bool *>(update.values), update.count, update.array_index);
+			break;
+		case api::effect_uniform_value_type::floating_point:
+			set_uniform_value(*variable, static_cast<const float *>(update.values), update.count, update.array_index);
+			break;
+		case api::effect_uniform_value_type::signed_integer:
+			set_uniform_value(*variable, static_cast<const int32_t *>(update.values), update.count, update.array_index);
+			break;
+		case api::effect_uniform_value_type::unsigned_integer:
+			set_uniform_value(*variable, static_cast<const uint32_t *>(update.values), update.count, update.array_index);
+			break;
+		}
 	}
+
+#if RESHADE_ADDON
+	_is_in_batched_uniform_update = false;
+#endif
 }
 
-reshade::api::effect_texture_variable reshade::runtime::find_texture_variable(const char *effect_name_in, const char *variable_name_in) const
+void reshade::runtime::enumerate_texture_variables(const char *effect_name_in, void(*callback)(effect_runtime *runtime, api::effect_texture_variable variable, void *user_data), void *user_data)
 {
-	if (is_loading() || variable_name_in == nullptr)
-		return { 0 };
+	if (is_loading())
+		return;
 
 	const std::filesystem::path effect_name = effect_name_in != nullptr ? std::filesystem::u8path(effect_name_in) : std::filesystem::path();
-	const std::string_view variable_name(variable_name_in);
 
 	for (const texture &variable : _textures)
 	{
@@ -454,13 +462,21 @@ reshade::api::effect_texture_variable reshade::runtime::find_texture_variable(co
 				}) == variable.shared.cend())
 			continue;
 
-		if (variable.name != variable_name && variable.unique_name != variable_name)
-			continue;
-
-		return { reinterpret_cast<uintptr_t>(&variable) };
+		callback(this, { reinterpret_cast<uintptr_t>(&variable) }, user_data);
 	}
+}
 
-	return { 0 };
+reshade::api::effect_texture_variable reshade::runtime::find_texture_variable(const char *effect_name, const char *variable_name) const
+{
+	if (is_loading() || variable_name == nullptr || (effect_name != nullptr && *effect_name == '\0'))
+		return { 0 };
+
+	return { _texture_lookup_index.find(effect_name != nullptr ? effect_name : std::string_view(), variable_name) };
+}
+void reshade::runtime::find_texture_variables(const char *effect_name, size_t count, const char *const *variable_names, api::effect_texture_variable *out_variables) const
+{
+	for (size_t i = 0; i < count; ++i)
+		out_variables[i] = find_texture_variable(effect_name, variable_names[i]);
 }
 
 void reshade::runtime::get_texture_variable_name(api::effect_texture_variable handle, char *value, size_t *size) const
@@ -766,26 +782,17 @@ void reshade::runtime::enumerate_techniques(const char *effect_name_in, void(*ca
 	}
 }
 
-reshade::api::effect_technique reshade::runtime::find_technique(const char *effect_name_in, const char *technique_name_in)
+reshade::api::effect_technique reshade::runtime::find_technique(const char *effect_name, const char *technique_name)
 {
-	if (is_loading() || technique_name_in == nullptr)
+	if (is_loading() || technique_name == nullptr || (effect_name != nullptr && *effect_name == '\0'))
 		return { 0 };
 
-	const std::filesystem::path effect_name = effect_name_in != nullptr ? std::filesystem::u8path(effect_name_in) : std::filesystem::path();
-	const std::string_view technique_name(technique_name_in);
-
-	for (const technique &technique : _techniques)
-	{
-		if (effect_name_in != nullptr && _effects[technique.effect_index].source_file.filename() != effect_name)
-			continue;
-
-		if (technique.name != technique_name)
-			continue;
-
-		return { reinterpret_cast<uintptr_t>(&technique) };
-	}
-
-	return { 0 };
+	return { _technique_lookup_index.find(effect_name != nullptr ? effect_name : std::string_view(), technique_name) };
+}
+void reshade::runtime::find_techniques(const char *effect_name, size_t count, const char *const *technique_names, api::effect_technique *out_techniques)
+{
+	for (size_t i = 0; i < count; ++i)
+		out_techniques[i] = find_technique(effect_name, technique_names[i]);
 }
 
 void reshade::runtime::get_technique_name(api::effect_technique handle, char *value, size_t *size) const
@@ -1303,6 +1310,9 @@ void reshade::runtime::render_technique(api::effect_technique handle, api::comma
 	invoke_addon_event<addon_event::reshade_begin_effects>(this, cmd_list, rtv, rtv_srgb);
 #endif
 
+	// Contents of the passed render target are unknown, so always copy it before it is sampled
+	_effect_permutations[permutation_index].color_tex_up_to_date = false;
+
 	render_technique(*tech, cmd_list, back_buffer_resource, rtv, rtv_srgb, permutation_index);
 
 #if RESHADE_ADDON
@@ -1465,3 +1475,54 @@ void reshade::runtime::reload_effect_next_frame(const char *effect_name)
 			_reload_required_effects.emplace_back(effect_index, static_cast<size_t>(0u));
 	}
 }
+
+template <typename T, size_t SAMPLES>
+static void get_statistics(const moving_average<T, SAMPLES> &durations, reshade::api::effect_statistics *out_statistics)
+{
+	out_statistics->average = durations;
+	out_statistics->minimum = durations.minimum();
+	out_statistics->maximum = durations.maximum();
+	out_statistics->percentile_95 = durations.percentile(95);
+	out_statistics->percentile_99 = durations.percentile(99);
+}
+
+bool reshade::runtime::get_technique_statistics(api::effect_technique handle, api::effect_statistics *out_cpu_time, api::effect_statistics *out_gpu_time) const
+{
+	const auto tech = reinterpret_cast<const technique *>(handle.handle);
+	if (tech == nullptr || (tech->average_cpu_duration.count() == 0 && tech->average_gpu_duration.count() == 0))
+		return false;
+
+	if (out_cpu_time != nullptr)
+		get_statistics(tech->average_cpu_duration, out_cpu_time);
+	if (out_gpu_time != nullptr)
+		get_statistics(tech->average_gpu_duration, out_gpu_time);
+
+	return true;
+}
+bool reshade::runtime::get_technique_pass_statistics(api::effect_technique handle, size_t pass_index, api::effect_statistics *out_gpu_time) const
+{
+	const auto tech = reinterpret_cast<const technique *>(handle.handle);
+	if (tech == nullptr || pass_index >= tech->permutations[0].passes.size() || out_gpu_time == nullptr ||
+		tech->permutations[0].passes[pass_index].average_gpu_duration.count() == 0)
+		return false;
+
+	get_statistics(tech->permutations[0].passes[pass_index].average_gpu_duration, out_gpu_time);
+
+	return true;
+}
+bool reshade::runtime::get_addon_statistics(const char *addon_name, api::effect_statistics *out_cpu_time) const
+{
+	if (addon_name == nullptr || out_cpu_time == nullptr)
+		return false;
+
+#if RESHADE_ADDON
+	if (const auto it = _addon_cpu_durations.find(addon_name);
+		it != _addon_cpu_durations.end() && it->second.count() != 0)
+	{
+		get_statistics(it->second, out_cpu_time);
+		return true;
+	}
+#endif
+
+	return false;
+}
@@ -126,6 +126,11 @@ void reshade::runtime::init_gui()
 }
 void reshade::runtime::deinit_gui()
 {
+	// Background checks of edited code access the runtime, so wait for those to finish
+	for (editor_instance &instance : _editors)
+		if (instance.check_result.valid())
+			instance.check_result.wait();
+
 	ImGui::DestroyContext(_imgui_context);
 }
 
@@ -2590,7 +2595,7 @@ void reshade::runtime::draw_gui_statistics()
 		ImGui::Text("Format %u (%u bpc)", static_cast<unsigned int>(_effect_permutations[0].color_format), api::format_bit_depth(_effect_permutations[0].color_format));
 		ImGui::Text("%*.3f ms", gpu_digits + 4, _last_frame_duration.count() * 1e-6f);
 		if (_gather_gpu_statistics && post_processing_time_gpu != 0)
-			ImGui::Text("%*.3f ms GPU", gpu_digits + 4, (post_processing_time_gpu * 1e-6f));
+			ImGui::Text("%*.3f ms GPU (%llu frames ago)", gpu_digits + 4, (post_processing_time_gpu * 1e-6f), _timestamp_latency);
 
 		ImGui::EndGroup();
 	}
@@ -2851,9 +2856,16 @@ void reshade::runtime::draw_gui_statistics()
 			for (uint32_t level = 0, width = tex.width, height = tex.height, depth = tex.depth; level < tex.levels; ++level, width /= 2, height /= 2, depth /= 2)
 				memory_size += static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * texture_format_info(tex.format).bytes_per_pixel;
 
-			post_processing_memory_size += memory_size;
+			// Transient textures may alias the resource of another texture, in which case the memory was already accounted for
+			const bool aliased = std::any_of(_textures.cbegin(), _textures.cbegin() + texture_index,
+				[this, &tex](const texture &item) {
+					return item.resource == tex.resource && std::any_of(item.shared.cbegin(), item.shared.cend(),
+						[this](size_t effect_index) { return _effects[effect_index].rendering; });
+				});
+			if (!aliased)
+				post_processing_memory_size += memory_size;
 
-			ImGui::TextColored(ImVec4(1, 1, 1, 1), "%s%s", tex.unique_name.c_str(), tex.shared.size() > 1 ? " (pooled)" : "");
+			ImGui::TextColored(ImVec4(1, 1, 1, 1), "%s%s", tex.unique_name.c_str(), tex.shared.size() > 1 ? " (pooled)" : aliased ? " (aliased)" : "");
 			switch (tex.type)
 			{
 			case reshadefx::texture_type::texture_1d:
@@ -4653,6 +4665,60 @@ void reshade::runtime::draw_code_editor(editor_instance &instance)
 
 	instance.editor.render("##editor", _editor_palette, false, _imgui_context->IO.Fonts->Fonts[_imgui_context->IO.Fonts->Fonts.Size - 1], _editor_font_size);
 
+	// Check edited effect code in the background while typing, so that errors show up without having to save and reload the effect first
+	if (instance.check_result.valid() && instance.check_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		editor_check_result result = instance.check_result.get();
+
+		// Parser result still applies to the same preprocessed source, even if the text was changed again in the meantime
+		instance.check_source_hash = result.source_hash;
+		instance.check_parser_errors = std::move(result.parser_errors);
+
+		// Discard errors if the text was changed again in the meantime
+		if (instance.check_version == instance.editor.get_text_version())
+		{
+			instance.editor.clear_errors();
+
+			parse_errors(result.errors,
+				[&instance](const std::string_view file, int line, const std::string_view message) {
+					// Ignore errors that aren't in the current source file
+					if (file != instance.file_path.u8string())
+						return;
+
+					instance.editor.add_error(line, message, message.find("error") == std::string::npos);
+				});
+
+			instance.checked_version = instance.check_version;
+		}
+	}
+
+	if (!instance.generated && instance.editor.is_modified() && !is_loading() &&
+		instance.effect_index < _effects.size() && !_effects[instance.effect_index].preprocessor_macros.empty())
+	{
+		const size_t text_version = instance.editor.get_text_version();
+
+		if (text_version != instance.edit_version)
+		{
+			instance.edit_version = text_version;
+			instance.edit_time = std::chrono::high_resolution_clock::now();
+		}
+		// Wait for typing to pause for a moment before starting a check
+		else if (text_version != instance.checked_version && !instance.check_result.valid() &&
+			std::chrono::high_resolution_clock::now() - instance.edit_time > std::chrono::milliseconds(500))
+		{
+			const effect &effect = _effects[instance.effect_index];
+
+			instance.check_version = text_version;
+
+			// Every editor has its own check in flight, with the result handed back through the future, so that editors cannot overwrite each other's results
+			instance.check_result = std::async(std::launch::async,
+				[this, source_file = effect.source_file, macros = effect.preprocessor_macros, include_paths = effect.include_paths, edited_file = instance.file_path, text = instance.editor.get_text(), result = editor_check_result { instance.check_source_hash, instance.check_parser_errors }]() mutable {
+					check_effect_source(source_file, macros, include_paths, edited_file, std::move(text), result);
+					return std::move(result);
+				});
+		}
+	}
+
 	// Disable keyboard shortcuts when the window is focused so they don't get triggered while editing text
 	const bool is_focused = ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows);
 	_ignore_shortcuts |= is_focused;
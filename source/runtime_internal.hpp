@@ -71,6 +71,8 @@ namespace reshade
 
 		std::vector<size_t> shared;
 		bool loaded = false;
+		// Name of the only technique accessing this texture if its contents never outlive that technique (the first access clears it), or empty otherwise
+		std::string transient_technique;
 
 		api::resource resource = {};
 		api::resource_view srv[2] = {};
@@ -177,8 +179,6 @@ namespace reshade
 		bool enabled = false;
 		bool enabled_in_screenshot = true;
 
-		uint32_t query_base_index = 0;
-
 		 int64_t time_left = 0;
 
 		moving_average<uint64_t, 60> average_cpu_duration;
@@ -195,6 +195,11 @@ namespace reshade
 			std::vector<api::resource> modified_resources;
 			std::vector<api::resource_view> generate_mipmap_views;
 
+			// Results of the resource usage analysis done in 'create_effect', used to skip unnecessary copies and barriers during rendering
+			bool samples_back_buffer = false;
+			bool skip_barriers_before = false;
+			bool skip_barriers_after = false;
+
 			moving_average<uint64_t, 60> average_gpu_duration;
 		};
 
@@ -202,6 +207,8 @@ namespace reshade
 		{
 			std::vector<pass> passes;
 			bool created = false;
+			// Pipelines are only created once the technique is enabled or rendered, so this may be false even when the technique was created
+			bool pipelines_created = false;
 		};
 
 		std::vector<permutation> permutations;
@@ -223,9 +230,40 @@ namespace reshade
 		std::vector<std::filesystem::path> included_files;
 		std::vector<std::pair<std::string, std::string>> definitions;
 
+		// Preprocessor configuration of the first permutation, used to check edited source code in the code editor
+		std::vector<std::pair<std::string, std::string>> preprocessor_macros;
+		std::vector<std::filesystem::path> include_paths;
+
 		std::vector<uniform> uniforms;
 		std::vector<uint8_t> uniform_data_storage;
+		// Byte range of the uniform data storage that was modified since it was last uploaded to the constant buffer
+		size_t uniform_data_dirty_begin = 0;
+		size_t uniform_data_dirty_end = 0;
 		api::resource cb = {};
+		// In D3D12 and Vulkan the constant buffer is split into slices that are cycled through, so that uploading new data never overwrites data the GPU may still read from a previous frame
+		static constexpr uint32_t cb_frames_in_flight = 4;
+		static constexpr uint32_t cb_slices_per_frame = 4;
+		size_t cb_slice_size = 0;
+		uint32_t cb_slice_count = 1;
+		uint32_t cb_slice_index = 0;
+		uint32_t cb_slices_used_in_frame = 0;
+		uint64_t cb_slice_frame = std::numeric_limits<uint64_t>::max();
+		// Last frame in which a slice of each frame set was bound, which has to be finished on the GPU before that set is written again
+		uint64_t cb_set_frame[cb_frames_in_flight] = { std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max() };
+
+		void mark_uniform_data_dirty(size_t offset, size_t size)
+		{
+			if (uniform_data_dirty_begin == uniform_data_dirty_end)
+			{
+				uniform_data_dirty_begin = offset;
+				uniform_data_dirty_end = offset + size;
+			}
+			else
+			{
+				uniform_data_dirty_begin = std::min(uniform_data_dirty_begin, offset);
+				uniform_data_dirty_end = std::max(uniform_data_dirty_end, offset + size);
+			}
+		}
 
 		struct binding
 		{
@@ -244,14 +282,61 @@ namespace reshade
 			std::unordered_map<std::string, std::string> assembly;
 
 			api::pipeline_layout layout = {};
-			api::descriptor_table cb_table = {};
+			// One descriptor table per constant buffer slice
+			std::vector<api::descriptor_table> cb_tables;
 			api::descriptor_table sampler_table = {};
 
 			std::vector<binding> texture_semantic_to_binding;
 		};
 
 		std::vector<permutation> permutations;
+	};
+
+	/// <summary>
+	/// Compiled result of an effect for a specific set of preprocessor definitions, kept around so that switching between presets does not have to compile it again.
+	/// </summary>
+	struct effect_variant
+	{
+		std::filesystem::path source_file;
+		size_t source_hash = 0;
+		size_t spec_constants_hash = 0;
 
-		api::query_heap query_heap = {};
+		std::vector<std::filesystem::path> included_files;
+		std::vector<std::pair<std::string, std::string>> definitions;
+
+		/// <summary>
+		/// Effect module with specialization constants still set to their default values.
+		/// </summary>
+		reshadefx::effect_module module;
+		std::string generated_code;
+		std::unordered_map<std::string, std::string> cso;
+		std::unordered_map<std::string, std::string> assembly;
+		/// <summary>
+		/// Warnings reported while compiling this variant, which are restored when it is reused.
+		/// </summary>
+		std::string errors;
+
+		/// <summary>
+		/// Value of the use counter of the cache when this variant was last used, so that the least recently used variant can be evicted first.
+		/// </summary>
+		uint64_t last_used = 0;
+	};
+
+	/// <summary>
+	/// Decoded pixel data of an image file referenced via the "source" annotation of a texture, kept around so that reloading does not have to decode it again.
+	/// </summary>
+	struct texture_source
+	{
+		std::filesystem::path source_file;
+		std::filesystem::file_time_type last_write_time;
+		reshadefx::texture_format format = reshadefx::texture_format::unknown;
+
+		uint32_t width = 0;
+		uint32_t height = 1;
+		uint32_t depth = 1;
+		/// <summary>
+		/// Pixel data already collapsed to the number of components of the <see cref="format"/>.
+		/// </summary>
+		std::vector<uint8_t> pixels;
 	};
 }
@@ -7,7 +7,7 @@
 #include "vulkan_impl_command_queue.hpp"
 #include "vulkan_impl_type_convert.hpp"
 #include "dll_log.hpp"
-#include <cstring> // std::memcpy
+#include <cstring> // std::memcmp, std::memcpy, std::memset
 #include <algorithm> // std::copy_n, std::max
 
 #define vk _dispatch_table
@@ -103,6 +103,14 @@ reshade::vulkan::device_impl::device_impl(
 			log::message(log::level::error, "Failed to create private data slot!");
 		}
 	}
+
+	{	VkPipelineCacheCreateInfo create_info { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+
+		if (vk.CreatePipelineCache(_orig, &create_info, nullptr, &_pipeline_cache) != VK_SUCCESS)
+		{
+			log::message(log::level::error, "Failed to create pipeline cache!");
+		}
+	}
 }
 reshade::vulkan::device_impl::~device_impl()
 {
@@ -114,6 +122,8 @@ reshade::vulkan::device_impl::~device_impl()
 		vk.DestroyFramebuffer(_orig, render_pass_data.second.framebuffer, nullptr);
 	}
 
+	vk.DestroyPipelineCache(_orig, _pipeline_cache, nullptr);
+
 	vk.DestroyPrivateDataSlot(_orig, _private_data_slot, nullptr);
 
 	vk.DestroyDescriptorPool(_orig, _descriptor_pool, nullptr);
@@ -1614,8 +1624,10 @@ bool reshade::vulkan::device_impl::create_pipeline(api::pipeline_layout layout,
 			create_info.pLibraryInterface = &interface_info;
 		}
 
+		const std::shared_lock<std::shared_mutex> pipeline_cache_lock(_pipeline_cache_mutex);
+
 		if (VkPipeline object = VK_NULL_HANDLE;
-			vk.CreateRayTracingPipelinesKHR(_orig, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &create_info, nullptr, &object) == VK_SUCCESS)
+			vk.CreateRayTracingPipelinesKHR(_orig, VK_NULL_HANDLE, _pipeline_cache, 1, &create_info, nullptr, &object) == VK_SUCCESS)
 		{
 			for (const VkShaderModule shader : shaders)
 				vk.DestroyShaderModule(_orig, shader, nullptr);
@@ -1640,8 +1652,10 @@ bool reshade::vulkan::device_impl::create_pipeline(api::pipeline_layout layout,
 			shaders.push_back(create_info.stage.module);
 		}
 
+		const std::shared_lock<std::shared_mutex> pipeline_cache_lock(_pipeline_cache_mutex);
+
 		if (VkPipeline object = VK_NULL_HANDLE;
-			vk.CreateComputePipelines(_orig, VK_NULL_HANDLE, 1, &create_info, nullptr, &object) == VK_SUCCESS)
+			vk.CreateComputePipelines(_orig, _pipeline_cache, 1, &create_info, nullptr, &object) == VK_SUCCESS)
 		{
 			vk.DestroyShaderModule(_orig, create_info.stage.module, nullptr);
 
@@ -1915,8 +1929,10 @@ bool reshade::vulkan::device_impl::create_pipeline(api::pipeline_layout layout,
 		}
 #endif
 
+		const std::shared_lock<std::shared_mutex> pipeline_cache_lock(_pipeline_cache_mutex);
+
 		if (VkPipeline object = VK_NULL_HANDLE;
-			vk.CreateGraphicsPipelines(_orig, VK_NULL_HANDLE, 1, &create_info, nullptr, &object) == VK_SUCCESS)
+			vk.CreateGraphicsPipelines(_orig, _pipeline_cache, 1, &create_info, nullptr, &object) == VK_SUCCESS)
 		{
 			if (render_pass != VK_NULL_HANDLE)
 				vk.DestroyRenderPass(_orig, render_pass, nullptr);
@@ -2665,3 +2681,88 @@ reshade::vulkan::command_list_immediate_impl *reshade::vulkan::device_impl::get_
 			return immediate_command_list;
 	return nullptr;
 }
+
+// Header written in front of the pipeline cache data, so that data from a different device or driver version is discarded before handing it to the driver
+struct pipeline_cache_file_header
+{
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint32_t driver_version;
+	uint8_t driver_uuid[VK_UUID_SIZE];
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+};
+
+static void get_pipeline_cache_file_header(const GladVulkanContext &dispatch_table, VkPhysicalDevice physical_device, pipeline_cache_file_header &header)
+{
+	VkPhysicalDeviceProperties2 device_props { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+	VkPhysicalDeviceIDProperties device_id_props { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+	device_props.pNext = &device_id_props;
+	dispatch_table.GetPhysicalDeviceProperties2(physical_device, &device_props);
+
+	std::memset(&header, 0, sizeof(header));
+	header.vendor_id = device_props.properties.vendorID;
+	header.device_id = device_props.properties.deviceID;
+	header.driver_version = device_props.properties.driverVersion;
+	std::memcpy(header.driver_uuid, device_id_props.driverUUID, VK_UUID_SIZE);
+	std::memcpy(header.pipeline_cache_uuid, device_props.properties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+bool reshade::vulkan::device_impl::merge_pipeline_cache_data(const std::string &data)
+{
+	if (_pipeline_cache == VK_NULL_HANDLE || data.size() <= sizeof(pipeline_cache_file_header))
+		return false;
+
+	pipeline_cache_file_header header;
+	get_pipeline_cache_file_header(_dispatch_table, _physical_device, header);
+
+	if (std::memcmp(data.data(), &header, sizeof(header)) != 0)
+		return false;
+
+	VkPipelineCacheCreateInfo create_info { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	create_info.initialDataSize = data.size() - sizeof(header);
+	create_info.pInitialData = data.data() + sizeof(header);
+
+	VkPipelineCache src_cache = VK_NULL_HANDLE;
+	if (vk.CreatePipelineCache(_orig, &create_info, nullptr, &src_cache) != VK_SUCCESS)
+		return false;
+
+	VkResult result;
+	{
+		const std::unique_lock<std::shared_mutex> lock(_pipeline_cache_mutex);
+
+		result = vk.MergePipelineCaches(_orig, _pipeline_cache, 1, &src_cache);
+	}
+
+	vk.DestroyPipelineCache(_orig, src_cache, nullptr);
+
+	return result == VK_SUCCESS;
+}
+bool reshade::vulkan::device_impl::get_pipeline_cache_data(std::string &data)
+{
+	if (_pipeline_cache == VK_NULL_HANDLE)
+		return false;
+
+	pipeline_cache_file_header header;
+	get_pipeline_cache_file_header(_dispatch_table, _physical_device, header);
+
+	// Size may grow between the two calls if pipelines are created in the meantime, in which case the driver returns 'VK_INCOMPLETE'
+	size_t size = 0;
+	VkResult result;
+	do
+	{
+		if (vk.GetPipelineCacheData(_orig, _pipeline_cache, &size, nullptr) != VK_SUCCESS || size == 0)
+			return false;
+
+		data.resize(sizeof(header) + size);
+		result = vk.GetPipelineCacheData(_orig, _pipeline_cache, &size, data.data() + sizeof(header));
+	}
+	while (result == VK_INCOMPLETE);
+
+	if (result != VK_SUCCESS)
+		return false;
+
+	data.resize(sizeof(header) + size);
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	return true;
+}
@@ -14,6 +14,7 @@
 #include "reshade_api_object_impl.hpp"
 #include <mutex>
 #include <shared_mutex>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -108,6 +109,19 @@ namespace reshade::vulkan
 
 		command_list_immediate_impl *get_immediate_command_list();
 
+		/// <summary>
+		/// Merges pipeline cache data previously retrieved via <see cref="get_pipeline_cache_data"/> into the pipeline cache used for all pipelines created through this device.
+		/// </summary>
+		/// <param name="data">Pipeline cache data, which is ignored if it was created with a different device or driver.</param>
+		/// <returns><see langword="true"/> if the data was merged, <see langword="false"/> otherwise.</returns>
+		bool merge_pipeline_cache_data(const std::string &data);
+		/// <summary>
+		/// Gets the contents of the pipeline cache used for all pipelines created through this device, prefixed with a header identifying the device and driver.
+		/// </summary>
+		/// <param name="data">Receives the pipeline cache data.</param>
+		/// <returns><see langword="true"/> if the data was retrieved, <see langword="false"/> otherwise.</returns>
+		bool get_pipeline_cache_data(std::string &data);
+
 		template <VkObjectType type>
 		object_data<type> *register_object(typename object_data<type>::Handle object, object_data<type> &&initial_data = object_data<type>())
 		{
@@ -162,6 +176,9 @@ namespace reshade::vulkan
 		VmaAllocator _alloc = nullptr;
 		VkDescriptorPool _descriptor_pool = VK_NULL_HANDLE;
 		VkPrivateDataSlot _private_data_slot = VK_NULL_HANDLE;
+		VkPipelineCache _pipeline_cache = VK_NULL_HANDLE;
+		// Pipeline creation only needs shared access, but merging into the pipeline cache requires it to be externally synchronized
+		std::shared_mutex _pipeline_cache_mutex;
 
 		std::shared_mutex _mutex;
 		std::unordered_map<size_t, VkRenderPassBeginInfo> _render_pass_lookup;
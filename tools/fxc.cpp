@@ -7,10 +7,49 @@
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
 #include "version.h"
+#include <new>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 
+// Keep track of all heap allocations, so that they can be reported with '--print-allocations'
+static std::atomic<size_t> s_allocation_count = 0;
+static std::atomic<size_t> s_allocation_size = 0;
+
+void *operator new(size_t size)
+{
+	s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+	s_allocation_size.fetch_add(size, std::memory_order_relaxed);
+
+	if (void *const ptr = std::malloc(size != 0 ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+struct allocation_counter
+{
+	allocation_counter() : count(s_allocation_count.load(std::memory_order_relaxed)), size(s_allocation_size.load(std::memory_order_relaxed)) {}
+
+	void print(const char *stage)
+	{
+		const allocation_counter current;
+		std::cerr << stage << ": " << (current.count - count) << " allocations (" << (current.size - size) << " bytes)" << std::endl;
+		*this = current;
+	}
+
+	size_t count, size;
+};
+
 static void print_usage(const char *path)
 {
 	printf(R"(usage: %s [options] <filename>
@@ -42,6 +81,7 @@ Options:
   --spec-constants          Convert uniform variables to specialization constants.
   --invert-y                Insert code to invert the Y component of the output position in vertex shaders (only applies to GLSL/SPIR-V code generation).
   --vulkan-semantics        Generate GLSL/SPIR-V code under Vulkan semantics, instead of OpenGL semantics.
+  --print-allocations       Print the number of heap allocations made by each compilation stage to standard error.
 	)", path);
 }
 
@@ -62,6 +102,7 @@ int main(int argc, char *argv[])
 	bool invert_y_axis = false;
 	bool spec_constants = false;
 	bool vulkan_semantics = false;
+	bool print_allocations = false;
 	unsigned int shader_model = 50;
 	unsigned int optimization_level = 1;
 
@@ -124,6 +165,8 @@ int main(int argc, char *argv[])
 				spec_constants = true;
 			else if (0 == std::strcmp(arg, "--vulkan-semantics"))
 				vulkan_semantics = true;
+			else if (0 == std::strcmp(arg, "--print-allocations"))
+				print_allocations = true;
 
 			if (i + 1 >= argc)
 				continue;
@@ -188,7 +231,14 @@ int main(int argc, char *argv[])
 	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
 	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
 
-	if (!pp.append_file(source_file))
+	allocation_counter allocations;
+
+	const bool preprocessed = pp.append_file(source_file);
+
+	if (print_allocations)
+		allocations.print("Preprocessing");
+
+	if (!preprocessed)
 	{
 		if (error_file == nullptr)
 			std::cout << pp.errors() << std::endl;
@@ -214,12 +264,17 @@ int main(int argc, char *argv[])
 	else if (generate_glsl)
 		backend.reset(reshadefx::create_codegen_glsl(vulkan_semantics, debug_info, spec_constants, invert_y_axis));
 	else if (generate_spirv)
-		backend.reset(reshadefx::create_codegen_spirv(vulkan_semantics, debug_info, spec_constants, invert_y_axis));
+		backend.reset(reshadefx::create_codegen_spirv(vulkan_semantics, debug_info, spec_constants, false, invert_y_axis));
 	else
 		return 1;
 
 	reshadefx::parser parser;
-	if (!parser.parse(pp.output(), backend.get()))
+	const bool parsed = parser.parse(pp.output(), backend.get());
+
+	if (print_allocations)
+		allocations.print("Parsing");
+
+	if (!parsed)
 	{
 		if (error_file == nullptr)
 			std::cout << pp.errors() << parser.errors() << std::endl;
@@ -246,6 +301,9 @@ int main(int argc, char *argv[])
 		code = backend->finalize_code();
 	}
 
+	if (print_allocations)
+		allocations.print("Code generation");
+
 	if (output_file != nullptr)
 	{
 		std::ofstream(output_file, std::ios::binary).write(code.data(), code.size());